@@ -0,0 +1,333 @@
+//
+//  bitmap.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "gcstack.h"
+#include "errorhandling.h"
+#include "readability.h"
+#include "simd.h"
+#include "group.h"
+
+#include "bitmap.h"
+
+void bitmap_Delete(void* const p)
+{
+	macro_err_return(p == NULL);
+
+	bitmap* const a = (bitmap* const)p;
+	free(a->words);
+	a->words = NULL;
+	a->length = 0;
+}
+
+bitmap* bitmap_GcAlloc(gcstack* const gc)
+{
+	return (bitmap*)gcstack_malloc
+	(gc, sizeof(bitmap), bitmap_Delete);
+}
+
+bitmap* bitmap_InitWithSize
+(bitmap* const a, const int start, const int length)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(length < 0);
+
+	a->start = start & ~63;
+	a->length = length;
+	a->words = length == 0 ? NULL :
+	calloc(length, sizeof(unsigned long long));
+	return a;
+}
+
+void bitmap_FillWords
+(unsigned long long* const words, const int n, const int base,
+ int from, int to, const int bit)
+{
+	long long lo = (long long)from - base;
+	long long hi = (long long)to - base;
+	if (lo < 0) lo = 0;
+	if (hi > 64LL*n) hi = 64LL*n;
+	if (lo >= hi) return;
+
+	int ws = (int)(lo >> 6);
+	const int we = (int)((hi-1) >> 6);
+	unsigned long long mask;
+	if (ws == we) {
+		mask = (~0ULL >> (64-(hi-lo))) << (lo & 63);
+		if (bit) words[ws] |= mask;
+		else words[ws] &= ~mask;
+		return;
+	}
+
+	mask = ~0ULL << (lo & 63);
+	if (bit) words[ws] |= mask;
+	else words[ws] &= ~mask;
+
+	for (ws++; ws < we; ws++)
+		words[ws] = bit ? ~0ULL : 0;
+
+	mask = ~0ULL >> (63 - ((hi-1) & 63));
+	if (bit) words[we] |= mask;
+	else words[we] &= ~mask;
+}
+
+int bitmap_WordsToBoundaries
+(const unsigned long long* const words, const int n, const int base,
+ int* const out)
+{
+	unsigned long long w, changes;
+	unsigned long long carry = 0;
+	int i, k = 0;
+	for (i = 0; i < n; i++) {
+		w = words[i];
+
+		// A bit differing from the one before it is a boundary.
+		changes = w ^ ((w << 1) | carry);
+		carry = w >> 63;
+		while (changes != 0) {
+			out[k++] = base + (i << 6) + __builtin_ctzll(changes);
+			changes &= changes - 1;
+		}
+	}
+
+	if (carry)
+		out[k++] = base + (n << 6);
+
+	return k;
+}
+
+int bitmap_CountWordBoundaries
+(const unsigned long long* const words, const int n)
+{
+	unsigned long long w;
+	unsigned long long carry = 0;
+	int i, k = 0;
+	for (i = 0; i < n; i++) {
+		w = words[i];
+		k += __builtin_popcountll(w ^ ((w << 1) | carry));
+		carry = w >> 63;
+	}
+
+	return k + (int)carry;
+}
+
+bitmap* bitmap_InitWithGroup(bitmap* const a, const group* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+	macro_err_return_null(b->length % 2 != 0);
+
+	if (b->length == 0)
+		return bitmap_InitWithSize(a, 0, 0);
+
+	const int* const p = b->pointer;
+	const int len = b->length;
+	const int start = p[0] & ~63;
+	bitmap_InitWithSize
+	(a, start, (int)(((long long)p[len-1] - start + 63) >> 6));
+
+	int i;
+	for (i = 0; i < len; i += 2)
+		bitmap_FillWords(a->words, a->length, a->start, p[i], p[i+1], true);
+
+	return a;
+}
+
+group* bitmap_GcGroup(gcstack* const gc, const bitmap* const a)
+{
+	macro_err_return_null(a == NULL);
+
+	group* const res = group_GcAlloc(gc);
+	group_InitWithSize
+	(res, bitmap_CountWordBoundaries(a->words, a->length));
+	bitmap_WordsToBoundaries(a->words, a->length, a->start, res->pointer);
+	return res;
+}
+
+int bitmap_IsDense(const group* const a)
+{
+	macro_err_return_zero(a == NULL);
+
+	if (a->length < 2 || a->length % 2 != 0)
+		return false;
+
+	const long long span =
+	(long long)a->pointer[a->length-1] - a->pointer[0];
+	return span < 32LL*a->length;
+}
+
+int bitmap_Size(const bitmap* const a)
+{
+	macro_err_return_zero(a == NULL);
+
+	return simd_PopCount(a->words, a->length);
+}
+
+//
+// Creates a bitmap covering the range from 'start' to 'end' with the
+// words of 'a' copied in place. The range must include 'a'.
+//
+bitmap* bitmapCopyWithRange
+(gcstack* const gc, const bitmap* const a, const int start, const int end);
+
+bitmap* bitmapCopyWithRange
+(gcstack* const gc, const bitmap* const a, const int start, const int end)
+{
+	bitmap* const res = bitmap_GcAlloc(gc);
+	bitmap_InitWithSize
+	(res, start, (int)(((long long)end - (start & ~63) + 63) >> 6));
+	if (a->length > 0)
+		memcpy(res->words + ((a->start - res->start) >> 6), a->words,
+		       sizeof(unsigned long long)*a->length);
+
+	return res;
+}
+
+//
+// The member id right after the last bit.
+//
+int bitmapEnd(const bitmap* const a);
+
+int bitmapEnd(const bitmap* const a)
+{
+	return a->start + (a->length << 6);
+}
+
+bitmap* bitmap_GcAnd
+(gcstack* const gc, const bitmap* const a, const bitmap* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	const int start = a->start > b->start ? a->start : b->start;
+	const int endA = bitmapEnd(a);
+	const int endB = bitmapEnd(b);
+	const int end = endA < endB ? endA : endB;
+	if (a->length == 0 || b->length == 0 || end <= start)
+		return bitmap_InitWithSize(bitmap_GcAlloc(gc), 0, 0);
+
+	bitmap* const res = bitmap_InitWithSize
+	(bitmap_GcAlloc(gc), start, (end - start) >> 6);
+	simd_Words(res->words,
+		   a->words + ((start - a->start) >> 6),
+		   b->words + ((start - b->start) >> 6),
+		   res->length, SIMD_WORDS_AND);
+	return res;
+}
+
+bitmap* bitmap_GcOr
+(gcstack* const gc, const bitmap* const a, const bitmap* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	if (b->length == 0)
+		return bitmapCopyWithRange(gc, a, a->start, bitmapEnd(a));
+	if (a->length == 0)
+		return bitmapCopyWithRange(gc, b, b->start, bitmapEnd(b));
+
+	const int start = a->start < b->start ? a->start : b->start;
+	const int endA = bitmapEnd(a);
+	const int endB = bitmapEnd(b);
+	bitmap* const res = bitmapCopyWithRange
+	(gc, a, start, endA > endB ? endA : endB);
+
+	unsigned long long* const dest = res->words + ((b->start - start) >> 6);
+	simd_Words(dest, dest, b->words, b->length, SIMD_WORDS_OR);
+	return res;
+}
+
+bitmap* bitmap_GcExcept
+(gcstack* const gc, const bitmap* const a, const bitmap* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	bitmap* const res = bitmapCopyWithRange(gc, a, a->start, bitmapEnd(a));
+
+	const int start = a->start > b->start ? a->start : b->start;
+	const int endA = bitmapEnd(a);
+	const int endB = bitmapEnd(b);
+	const int end = endA < endB ? endA : endB;
+	if (a->length == 0 || b->length == 0 || end <= start)
+		return res;
+
+	unsigned long long* const dest = res->words + ((start - a->start) >> 6);
+	simd_Words(dest, dest, b->words + ((start - b->start) >> 6),
+		   (end - start) >> 6, SIMD_WORDS_ANDNOT);
+	return res;
+}
+
+bitmap* bitmap_GcAndGroup
+(gcstack* const gc, const bitmap* const a, const group* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	bitmap* const res = bitmapCopyWithRange(gc, a, a->start, bitmapEnd(a));
+
+	// Clear the gaps between the blocks.
+	const int* const p = b->pointer;
+	const int len = b->length;
+	int i, from = INT_MIN;
+	for (i = 0; i < len; i += 2) {
+		bitmap_FillWords(res->words, res->length, res->start,
+				 from, p[i], false);
+		from = i+1 < len ? p[i+1] : INT_MAX;
+	}
+
+	bitmap_FillWords(res->words, res->length, res->start,
+			 from, INT_MAX, false);
+	return res;
+}
+
+bitmap* bitmap_GcOrGroup
+(gcstack* const gc, const bitmap* const a, const group* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+	macro_err_return_null(b->length % 2 != 0);
+
+	const int* const p = b->pointer;
+	const int len = b->length;
+	int start = a->start;
+	int end = bitmapEnd(a);
+	if (len > 0) {
+		if (a->length == 0 || p[0] < start) start = p[0];
+		if (a->length == 0 || p[len-1] > end) end = p[len-1];
+	}
+
+	bitmap* const res = bitmapCopyWithRange(gc, a, start, end);
+	int i;
+	for (i = 0; i < len; i += 2)
+		bitmap_FillWords(res->words, res->length, res->start,
+				 p[i], p[i+1], true);
+
+	return res;
+}
+
+bitmap* bitmap_GcExceptGroup
+(gcstack* const gc, const bitmap* const a, const group* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	bitmap* const res = bitmapCopyWithRange(gc, a, a->start, bitmapEnd(a));
+
+	const int* const p = b->pointer;
+	const int len = b->length;
+	int i;
+	for (i = 0; i < len; i += 2)
+		bitmap_FillWords(res->words, res->length, res->start,
+				 p[i], i+1 < len ? p[i+1] : INT_MAX, false);
+
+	return res;
+}
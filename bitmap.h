@@ -0,0 +1,138 @@
+//
+//  bitmap.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MemGroups_bitmap_h
+#define MemGroups_bitmap_h
+
+	//
+	//	DENSE BITMAPS
+	//
+	//	A bitmap uses one bit per member id between its first and last
+	//	member. When a group is fragmented into many short blocks,
+	//	this takes less memory than the boundaries, and And, Or and
+	//	Except become straight loops over the words.
+	//	Use 'bitmap_IsDense' to decide which form to use.
+	//
+	typedef struct bitmap {
+		gcstack_item gc;
+
+		/* The member id of the first bit, a multiple of 64. */
+		int start;
+
+		/* The number of 64 bit words. */
+		int length;
+		unsigned long long* words;
+	} bitmap;
+
+	void bitmap_Delete
+	(void* const p);
+
+	bitmap* bitmap_GcAlloc
+	(gcstack* const gc);
+
+	//
+	// Initializes with all bits cleared, covering the member ids
+	// from 'start' rounded down to 64 and 'length' words on.
+	//
+	bitmap* bitmap_InitWithSize
+	(bitmap* const a, const int start, const int length);
+
+	//
+	// Initializes from a bitstream, which must be finite (even length).
+	//
+	bitmap* bitmap_InitWithGroup
+	(bitmap* const a, const group* const b);
+
+	//
+	// Creates a bitstream with the same members.
+	//
+	group* bitmap_GcGroup
+	(gcstack* const gc, const bitmap* const a);
+
+	//
+	// Returns true if a bitmap of the group takes less memory
+	// than its boundaries, which is when a block and the gap after it
+	// are on average shorter than 64 members.
+	//
+	int bitmap_IsDense
+	(const group* const a);
+
+	//
+	// Returns the number of members by counting bits.
+	//
+	int bitmap_Size
+	(const bitmap* const a);
+
+	//
+	// The Boolean operators between bitmaps.
+	// The result covers the range needed, so 'And' is only as
+	// long as the overlap.
+	//
+	bitmap* bitmap_GcAnd
+	(gcstack* const gc, const bitmap* const a, const bitmap* const b);
+
+	bitmap* bitmap_GcOr
+	(gcstack* const gc, const bitmap* const a, const bitmap* const b);
+
+	bitmap* bitmap_GcExcept
+	(gcstack* const gc, const bitmap* const a, const bitmap* const b);
+
+	//
+	// The Boolean operators between a bitmap and a bitstream.
+	// These set or clear the bits block by block, so the cost
+	// is the number of words in 'a' plus the blocks in 'b'.
+	// 'b' can be inverted except for 'Or'.
+	//
+	bitmap* bitmap_GcAndGroup
+	(gcstack* const gc, const bitmap* const a, const group* const b);
+
+	bitmap* bitmap_GcOrGroup
+	(gcstack* const gc, const bitmap* const a, const group* const b);
+
+	bitmap* bitmap_GcExceptGroup
+	(gcstack* const gc, const bitmap* const a, const group* const b);
+
+	//
+	//	WORD ARRAYS
+	//
+	//	These work on plain arrays of words where bit 0 of the first
+	//	word is member 'base'. They are shared with the bitmap chunks
+	//	in hybrid groups.
+	//
+
+	//
+	// Sets (bit = true) or clears (bit = false) the members from 'from'
+	// up to but not including 'to'. Members outside the words are
+	// ignored.
+	//
+	void bitmap_FillWords
+	(unsigned long long* const words, const int n, const int base,
+	 int from, int to, const int bit);
+
+	//
+	// Writes the boundaries of the members and returns the number
+	// written. There can be at most 64*n+1 boundaries.
+	//
+	int bitmap_WordsToBoundaries
+	(const unsigned long long* const words, const int n, const int base,
+	 int* const out);
+
+	//
+	// Returns the number of boundaries without writing them.
+	//
+	int bitmap_CountWordBoundaries
+	(const unsigned long long* const words, const int n);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
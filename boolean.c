@@ -58,6 +58,65 @@ void boolean_eval_BinaryOp(gcstack* const st)
 }
 
 
+void boolean_eval_ChainOp(gcstack* const st);
+
+//
+// Evaluates all arguments at top of the stack that are connected with
+// the same operator. Chains of '+' and '*' are evaluated in one sweep
+// instead of allocating a new bitstream for each step.
+//
+void boolean_eval_ChainOp(gcstack* const st)
+{
+	const char op = (char)((gcint*)st->root->next->next)->val;
+	if (op == '-') {
+		boolean_eval_BinaryOp(st);
+		return;
+	}
+	
+	// Count the arguments in the chain.
+	int n = 1;
+	gcstack_item* item = st->root->next;
+	while (item->next != NULL && item->next->next != NULL &&
+	       (char)((gcint*)item->next)->val == op) {
+		item = item->next->next;
+		n++;
+	}
+	
+	if (n == 2) {
+		boolean_eval_BinaryOp(st);
+		return;
+	}
+	
+	const group** const args = malloc(sizeof(group*)*n);
+	item = st->root->next;
+	int i;
+	for (i = 0; i < n; i++) {
+		args[i] = (group*)item;
+		if (i < n-1)
+			item = item->next->next;
+	}
+	
+	if (op == '*')
+		group_GcAndMany(st, n, args);
+	else
+		group_GcOrMany(st, n, args);
+	
+	// Pop arguments and operators from stack.
+	group* arg;
+	gcstack_item* opItem;
+	for (i = 0; i < n; i++) {
+		arg = (group*)args[i];
+		opItem = ((gcstack_item*)arg)->next;
+		gcstack_Pop(st, (gcstack_item*)arg);
+		group_Delete(arg);
+		free(arg);
+		if (i < n-1)
+			gcstack_free(st, opItem);
+	}
+	
+	free(args);
+}
+
 typedef struct expr_data
 {
 	gcstack* const st;
@@ -76,9 +135,10 @@ void boolean_eval_CheckPrecedence(expr_data* data, const int repeatIndex)
 	
 	// The ascii table is sorted by negative precedence.
 	// * < + < -
-	if (op2 >= op1) {
+	// A chain of the same '+' or '*' is evaluated when the chain ends.
+	if (op2 >= op1 && !(op2 == op1 && op1 != '-')) {
 		char op = (char)gcstack_PopInt(data->st);
-		boolean_eval_BinaryOp(data->st);
+		boolean_eval_ChainOp(data->st);
 		gcstack_PushInt(data->st, op);
 	}
 	
@@ -212,7 +272,7 @@ CLEAN_UP:
 	
 	// Evaluate all operators.
 	while (data.st->length > 1) {
-		boolean_eval_BinaryOp(data.st);
+		boolean_eval_ChainOp(data.st);
 	}
 	
 	group* b = (group*)data.st->root->next;
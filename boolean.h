@@ -23,6 +23,8 @@ extern "C" {
 	//
 	//	At this moment it only supports bitstream properties.
 	//	It evaluates A + B + C = (A + B) + C
+	//	Chains of the same '+' or '*' are computed in a single sweep
+	//	over all the bitstreams, see group_GcOrMany and group_GcAndMany.
 	//	This makes it possible to add Boolean functions in the future.
 	//
 	//	The idea is to provide easy prototyping and power-user features
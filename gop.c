@@ -449,12 +449,7 @@ void gop_RemoveProperty(gop* const g, const int propId)
 	// Add the property id to deleted bitstream for reuse.
 	group* b = group_InitWithValues
 	(group_GcAlloc(NULL), 2, (int[]){index, index+1});
-	group* c = g->m_deletedBitstreams;
-	group* d = group_GcOr(NULL, c, b);
-	gcstack_Swap(d, c);
-	g->m_deletedBitstreams = d;
-	group_Delete(c);
-	free(c);
+	group_OrInPlace(g->m_deletedBitstreams, b);
 	group_Delete(b);
 	free(b);
 	
@@ -540,13 +535,9 @@ int gop_AddMember(gop* const g, hash_table* const obj)
 	{
 		// Update the indices of deleted members to include the 'fakes' that has been added.
 		group* addedIds = group_InitWithValues(group_GcAlloc(NULL), 2, (int[]){id, newId});
-		group* newDeleted = group_GcOr(NULL, g->m_deletedMembers, addedIds);
-		group* oldDeleted = g->m_deletedMembers;
-		g->m_deletedMembers = newDeleted;
+		group_OrInPlace(g->m_deletedMembers, addedIds);
 		group_Delete(addedIds);
 		free(addedIds);
-		group_Delete(oldDeleted);
-		free(oldDeleted);
 		hasId = true;
 	}
 	
@@ -582,7 +573,6 @@ int gop_AddMember(gop* const g, hash_table* const obj)
 	
 	group* a;
 	group* b;
-	group* c;
 	b = group_InitWithValues
 	(group_GcAlloc(gc), 2, (const int[]){id, id+1});
 	
@@ -593,9 +583,7 @@ int gop_AddMember(gop* const g, hash_table* const obj)
 		a = g->m_bitstreamsArray[index];
 		if (a == NULL) continue;
 		
-		c = group_GcOr(gc, a, b);
-		// Switch stacks so the new one is kept.
-		gcstack_Swap(c, a);
+		group_OrInPlace(a, b);
 	} macro_bitstream_end_foreach(new)
 	
 	gcstack_Delete(gc);
@@ -632,14 +620,11 @@ void gop_SetDouble
 	// Double does not have a default value, so we need no condition here.
 	gop_CreateBitstreamArray(g);
 	
-	// Update the bitstream, cleaning up manually for saving one malloc call.
+	// Update the bitstream in place, which reuses the buffer.
 	// It takes only one operation to update all.
 	const int propIndex = propId%TYPE_STRIDE;
 	group* b = g->m_bitstreamsArray[propIndex];
-	group* c = group_GcOr(NULL, b, a);
-	gcstack_Swap(c, b);
-	group_Delete(b);
-	free(b);
+	group_OrInPlace(b, a);
 }
 
 double gop_GetDouble(gop* const g, const int propId, const int id)
@@ -685,20 +670,17 @@ void gop_SetString
 	
 	gop_CreateBitstreamArray(g);
 	
-	// Update the bitstream, cleaning up manually for saving one malloc call.
+	// Update the bitstream in place, which reuses the buffer.
 	// It takes only one operation to update all.
 	const int propIndex = propId%TYPE_STRIDE;
 	group* b = g->m_bitstreamsArray[propIndex];
 	
 	// If the string is NULL, then it is a default value
 	// and we subtract from the bitstream instead of adding.
-	group* c = val == NULL ?
-	group_GcExcept(NULL, b, a) :
-	group_GcOr(NULL, b, a);
-	
-	gcstack_Swap(c, b);
-	group_Delete(b);
-	free(b);
+	if (val == NULL)
+		group_ExceptInPlace(b, a);
+	else
+		group_OrInPlace(b, a);
 }
 
 const char* gop_GetString(gop* const g, const int propId, const int id)
@@ -738,20 +720,17 @@ void gop_SetInt
 	
 	gop_CreateBitstreamArray(g);
 	
-	// Update the bitstream, cleaning up manually for saving one malloc call.
+	// Update the bitstream in place, which reuses the buffer.
 	// It takes only one operation to update all.
 	const int propIndex = propId%TYPE_STRIDE;
 	group* b = g->m_bitstreamsArray[propIndex];
 	
-	// If the string is NULL, then it is a default value
-	// and we subtract from the bitstream instead of adding.
-	group* c = isDefault ?
-	group_GcExcept(NULL, b, a) :
-	group_GcOr(NULL, b, a);
-	
-	gcstack_Swap(c, b);
-	group_Delete(b);
-	free(b);
+	// If the value is default, then we subtract from the bitstream 
+	// instead of adding.
+	if (isDefault)
+		group_ExceptInPlace(b, a);
+	else
+		group_OrInPlace(b, a);
 }
 
 int gop_GetInt(gop* const g, const int propId, const int id)
@@ -794,20 +773,17 @@ void gop_SetBool
 	
 	gop_CreateBitstreamArray(g);
 	
-	// Update the bitstream, cleaning up manually for saving one malloc call.
+	// Update the bitstream in place, which reuses the buffer.
 	// It takes only one operation to update all.
 	int propIndex = propId%TYPE_STRIDE;
 	group* b = g->m_bitstreamsArray[propIndex];
 	
-	// If the string is NULL, then it is a default value
-	// and we subtract from the bitstream instead of adding.
-	group* c = isDefault ?
-	group_GcExcept(NULL, b, a) :
-	group_GcOr(NULL, b, a);
-	
-	gcstack_Swap(c, b);
-	group_Delete(b);
-	free(b);
+	// If the value is default, then we subtract from the bitstream 
+	// instead of adding.
+	if (isDefault)
+		group_ExceptInPlace(b, a);
+	else
+		group_OrInPlace(b, a);
 }
 
 int gop_GetBool(gop* const g, const int propId, const int id)
@@ -913,14 +889,12 @@ void gop_RemoveMember(gop* const g, const int index)
 	group* a;
 	group* b = group_InitWithValues
 	(group_GcAlloc(gc), 2, (int[]){index,index+1});
-	group* c;
 	macro_hashTable_foreach(obj) {
 		propId = macro_hashTable_id(obj);
 		a = getBitstream(g, propId);
 		if (a == NULL) continue;
 		
-		c = group_GcExcept(gc, a, b);
-		gcstack_Swap(c, a);
+		group_ExceptInPlace(a, b);
 	} macro_bitstream_end_foreach(obj)
 	
 	g->m_bitstreamsReady = false;
@@ -930,10 +904,7 @@ void gop_RemoveMember(gop* const g, const int index)
 	member_Delete(obj);
 	
 	// Add the member to bitstream of deleted members for reuse of index.
-	group* d = g->m_deletedMembers;
-	group* e = group_GcOr(gc, d, b);
-	gcstack_Swap(d, e);
-	g->m_deletedMembers = e;
+	group_OrInPlace(g->m_deletedMembers, b);
 	
 	gcstack_Delete(gc);
 	
@@ -946,18 +917,11 @@ void gop_RemoveMembers(gop* const g, const group* const prop)
 	macro_err_return(prop == NULL);
 	
 	gop_CreateMemberArray(g);
-	gcstack* gc = gcstack_Init(gcstack_Alloc());
 	
 	// Remove the group from all bitstream properties.
 	const gcstack_item* cursor = g->bitstreams->root->next;
-	group* exProp;
-	group* tmpProp;
 	for (; cursor != NULL; cursor = cursor->next)
-	{
-		exProp = (group*)cursor;
-		tmpProp = group_GcExcept(gc, exProp, prop);
-		gcstack_Swap(tmpProp, exProp);
-	}
+		group_ExceptInPlace((group*)cursor, prop);
 	
 	int index;
 	hash_table* obj;
@@ -972,14 +936,7 @@ void gop_RemoveMembers(gop* const g, const group* const prop)
 	g->m_membersReady = false;
 	
 	// Add the member to bitstream of deleted members for reuse of index.
-	group* const d = g->m_deletedMembers;
-	group* const e = group_GcOr(gc, d, prop);
-	gcstack_Swap(d, e);
-	g->m_deletedMembers = e;
-	
-	gcstack_Delete(gc);
-	
-	free(gc);
+	group_OrInPlace(g->m_deletedMembers, prop);
 }
 
 int gop_IsPropertyType(const int propId, const int type)
@@ -0,0 +1,228 @@
+//
+//  group-expr.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcstack.h"
+#include "errorhandling.h"
+#include "readability.h"
+#include "group.h"
+
+#include "group-expr.h"
+
+group_expr* exprGcNode
+(gcstack* const gc, const int op, const group_expr* const a, 
+ const group_expr* const b);
+
+group_expr* exprGcNode
+(gcstack* const gc, const int op, const group_expr* const a, 
+ const group_expr* const b)
+{
+	group_expr* const e = (group_expr*)gcstack_malloc
+	(gc, sizeof(group_expr), NULL);
+	e->op = op;
+	e->bitstream = NULL;
+	e->position = 0;
+	e->left = a;
+	e->right = b;
+	return e;
+}
+
+group_expr* group_expr_GcLeaf
+(gcstack* const gc, const group* const a)
+{
+	macro_err_return_null(a == NULL);
+
+	group_expr* const e = exprGcNode(gc, GROUP_EXPR_LEAF, NULL, NULL);
+	e->bitstream = a;
+	return e;
+}
+
+group_expr* group_expr_GcAnd
+(gcstack* const gc, const group_expr* const a, const group_expr* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	return exprGcNode(gc, GROUP_EXPR_AND, a, b);
+}
+
+group_expr* group_expr_GcOr
+(gcstack* const gc, const group_expr* const a, const group_expr* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	return exprGcNode(gc, GROUP_EXPR_OR, a, b);
+}
+
+group_expr* group_expr_GcExcept
+(gcstack* const gc, const group_expr* const a, const group_expr* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	return exprGcNode(gc, GROUP_EXPR_EXCEPT, a, b);
+}
+
+group_expr* group_expr_GcInvert
+(gcstack* const gc, const group_expr* const a, const int position)
+{
+	macro_err_return_null(a == NULL);
+
+	group_expr* const e = exprGcNode(gc, GROUP_EXPR_INVERT, a, NULL);
+	e->position = position;
+	return e;
+}
+
+//
+// The expression is compiled to a program in postfix order.
+// A number that is zero or more pushes the state of that input,
+// while the negative numbers are operators working on the stack.
+// An inversion is an exclusive or with an input that has a single
+// boundary at the position.
+//
+#define EXPR_AND	-1
+#define EXPR_OR		-2
+#define EXPR_EXCEPT	-3
+#define EXPR_XOR	-4
+
+typedef struct exprProgram {
+	int* code;
+	int length;
+	int* stack;
+
+	/* The bitstreams read by the program, and the bitstreams made
+	   for the inversions. */
+	const group** inputs;
+	int count;
+	group* views;
+	int viewCount;
+} exprProgram;
+
+int exprCount(const group_expr* const e);
+
+int exprCount(const group_expr* const e)
+{
+	if (e == NULL) return 0;
+
+	return 1 + (e->op == GROUP_EXPR_INVERT) + 
+	exprCount(e->left) + exprCount(e->right);
+}
+
+int exprInput
+(exprProgram* const prog, const int* const pointer, const int length);
+
+//
+// Returns the input with the boundaries, adding it the first time.
+//
+int exprInput
+(exprProgram* const prog, const int* const pointer, const int length)
+{
+	int i;
+	for (i = 0; i < prog->count; i++)
+		if (prog->inputs[i]->pointer == pointer && 
+		    prog->inputs[i]->length == length)
+			return i;
+
+	// A read only view, so the boundaries are never freed.
+	group* const view = prog->views + prog->viewCount++;
+	view->pointer = (int*)pointer;
+	view->length = length;
+	view->capacity = length;
+	view->readOnly = true;
+
+	prog->inputs[i] = view;
+	prog->count++;
+	return i;
+}
+
+void exprCompile(exprProgram* const prog, const group_expr* const e);
+
+void exprCompile(exprProgram* const prog, const group_expr* const e)
+{
+	switch (e->op) {
+		case GROUP_EXPR_LEAF:
+			prog->code[prog->length++] = exprInput
+			(prog, e->bitstream->pointer, e->bitstream->length);
+			return;
+		case GROUP_EXPR_INVERT:
+			exprCompile(prog, e->left);
+			prog->code[prog->length++] = exprInput(prog, &e->position, 1);
+			prog->code[prog->length++] = EXPR_XOR;
+			return;
+	}
+
+	exprCompile(prog, e->left);
+	exprCompile(prog, e->right);
+	prog->code[prog->length++] = e->op == GROUP_EXPR_AND ? EXPR_AND :
+	e->op == GROUP_EXPR_OR ? EXPR_OR : EXPR_EXCEPT;
+}
+
+int exprRun(const int n, const int* const states, void* const data);
+
+//
+// Runs the program on the states of the inputs.
+// This is the function of the sweep in 'group_GcSweep'.
+//
+int exprRun(const int n, const int* const states, void* const data)
+{
+	const exprProgram* const prog = (const exprProgram*)data;
+	macro_err_return_zero(n != prog->count);
+
+	int* const stack = prog->stack;
+	int top = 0;
+	int i, c;
+	for (i = 0; i < prog->length; i++)
+	{
+		c = prog->code[i];
+		if (c >= 0)
+		{
+			stack[top++] = states[c];
+			continue;
+		}
+
+		top--;
+		switch (c) {
+			case EXPR_AND: stack[top-1] &= stack[top]; break;
+			case EXPR_OR: stack[top-1] |= stack[top]; break;
+			case EXPR_EXCEPT: stack[top-1] &= !stack[top]; break;
+			case EXPR_XOR: stack[top-1] ^= stack[top]; break;
+		}
+	}
+	return stack[0];
+}
+
+group* group_expr_GcEval
+(gcstack* const gc, const group_expr* const e)
+{
+	macro_err_return_null(e == NULL);
+
+	// Every node needs at most two instructions and one input.
+	const int nodes = exprCount(e);
+	exprProgram prog;
+	prog.code = malloc(sizeof(int)*nodes*2);
+	prog.stack = prog.code+nodes;
+	prog.length = 0;
+	prog.inputs = malloc(sizeof(group*)*nodes);
+	prog.count = 0;
+	prog.views = malloc(sizeof(group)*nodes);
+	prog.viewCount = 0;
+	exprCompile(&prog, e);
+
+	// All operators are false when all inputs are false,
+	// so the result starts as false like the inputs.
+	group* const res = group_GcSweep
+	(gc, prog.count, prog.inputs, exprRun, &prog);
+
+	free(prog.views);
+	free(prog.inputs);
+	free(prog.code);
+	return res;
+}
@@ -0,0 +1,81 @@
+//
+//  group-expr.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MemGroups_group_expr_h
+#define MemGroups_group_expr_h
+
+	//
+	//	LAZY EXPRESSIONS
+	//
+	//	An expression such as (a Or b) Except (c Except b) computed
+	//	with the Gc operators creates a bitstream for every step.
+	//	Instead, a tree of operations can be built over existing
+	//	bitstreams and evaluated once. The evaluation walks through the
+	//	boundaries of all the bitstreams in sorted order, and at each
+	//	boundary it computes the whole expression from the states of
+	//	the bitstreams. No intermediate bitstream is created.
+	//
+	//	The bitstreams must not change before the expression is
+	//	evaluated, because they are not copied.
+	//
+	enum {
+		GROUP_EXPR_LEAF = 1,
+		GROUP_EXPR_AND = 2,
+		GROUP_EXPR_OR = 3,
+		GROUP_EXPR_EXCEPT = 4,
+		GROUP_EXPR_INVERT = 5
+	};
+
+	typedef struct group_expr {
+		gcstack_item gc;
+		int op;
+
+		/* The bitstream of a leaf. */
+		const group* bitstream;
+
+		/* Where an inversion starts, like in 'group_GcInvert'. */
+		int position;
+
+		const struct group_expr* left;
+		const struct group_expr* right;
+	} group_expr;
+
+	group_expr* group_expr_GcLeaf
+	(gcstack* const gc, const group* const a);
+
+	group_expr* group_expr_GcAnd
+	(gcstack* const gc, const group_expr* const a, const group_expr* const b);
+
+	group_expr* group_expr_GcOr
+	(gcstack* const gc, const group_expr* const a, const group_expr* const b);
+
+	group_expr* group_expr_GcExcept
+	(gcstack* const gc, const group_expr* const a, const group_expr* const b);
+
+	//
+	// Inverts the expression from 'position' and on,
+	// like 'group_GcInvert'.
+	//
+	group_expr* group_expr_GcInvert
+	(gcstack* const gc, const group_expr* const a, const int position);
+
+	//
+	// Computes the expression in a single sweep over all bitstreams.
+	// A bitstream used in several places is read only once.
+	//
+	group* group_expr_GcEval
+	(gcstack* const gc, const group_expr* const e);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
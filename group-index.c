@@ -0,0 +1,177 @@
+//
+//  group-index.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "gcstack.h"
+#include "errorhandling.h"
+#include "readability.h"
+#include "group.h"
+
+#include "group-index.h"
+
+void group_index_Delete(void* const p)
+{
+	macro_err_return(p == NULL);
+
+	group_index* const idx = (group_index* const)p;
+	free(idx->before);
+	idx->before = NULL;
+	idx->bitstream = NULL;
+	idx->blocks = 0;
+}
+
+group_index* group_index_GcAlloc(gcstack* const gc)
+{
+	return (group_index*)gcstack_malloc
+	(gc, sizeof(group_index), group_index_Delete);
+}
+
+group_index* group_index_InitWithGroup
+(group_index* const idx, const group* const a)
+{
+	macro_err_return_null(idx == NULL);
+	macro_err_return_null(a == NULL);
+
+	const int* const p = a->pointer;
+	const int len = a->length;
+	const int blocks = (len+1)/2;
+	idx->bitstream = a;
+	idx->blocks = blocks;
+	idx->before = malloc(sizeof(int)*(blocks+1));
+
+	int i, sum = 0;
+	for (i = 0; i+1 < len; i += 2)
+	{
+		idx->before[i/2] = sum;
+		sum += p[i+1] - p[i];
+	}
+
+	// The last block of an inverted bitstream has no end.
+	if (len % 2 != 0)
+		idx->before[blocks-1] = sum;
+
+	idx->before[blocks] = sum;
+	return idx;
+}
+
+int group_index_Size(const group_index* const idx)
+{
+	macro_err_return_zero(idx == NULL);
+
+	if (idx->bitstream->length % 2 != 0)
+		return -1;
+
+	return idx->before[idx->blocks];
+}
+
+int indexFindBlock(const group_index* const idx, const int k);
+
+//
+// Returns the block containing the member at position 'k'.
+// This is the last block with fewer members before it than 'k'+1.
+//
+int indexFindBlock(const group_index* const idx, const int k)
+{
+	const int* const before = idx->before;
+	int lo = 0, hi = idx->blocks-1, mid;
+	while (lo < hi)
+	{
+		mid = lo + (hi-lo+1)/2;
+		if (before[mid] <= k)
+			lo = mid;
+		else
+			hi = mid-1;
+	}
+	return lo;
+}
+
+int group_index_Select(const group_index* const idx, const int k)
+{
+	macro_err_return_zero(idx == NULL);
+
+	const int infinite = idx->bitstream->length % 2 != 0;
+	if (k < 0 || idx->blocks == 0 ||
+	    (!infinite && k >= idx->before[idx->blocks]))
+		return -1;
+
+	const int block = indexFindBlock(idx, k);
+	return idx->bitstream->pointer[2*block] + k - idx->before[block];
+}
+
+int group_index_Rank(const group_index* const idx, const int id)
+{
+	macro_err_return_zero(idx == NULL);
+
+	// Count the boundaries up to and including 'id'.
+	const int* const p = idx->bitstream->pointer;
+	int lo = 0, hi = idx->bitstream->length, mid;
+	while (lo < hi)
+	{
+		mid = lo + (hi-lo)/2;
+		if (p[mid] <= id)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+
+	// An odd count means 'id' is inside a block.
+	if (lo % 2 != 0)
+		return idx->before[lo/2] + id - p[lo-1];
+
+	return idx->before[lo/2];
+}
+
+group* group_index_GcPage
+(gcstack* const gc, const group_index* const idx,
+ const int offset, const int limit)
+{
+	macro_err_return_null(idx == NULL);
+	macro_err_return_null(offset < 0);
+	macro_err_return_null(limit < 0);
+
+	group* const res = group_GcAlloc(gc);
+	const int first = group_index_Select(idx, offset);
+	if (limit == 0 || first == -1)
+		return group_InitWithSize(res, 0);
+
+	const int* const p = idx->bitstream->pointer;
+	const int startBlock = indexFindBlock(idx, offset);
+	const int len = idx->bitstream->length;
+	if (limit > INT_MAX - offset && len % 2 != 0)
+	{
+		// The page has no end in an inverted bitstream.
+		group_InitWithSize(res, len - 2*startBlock);
+		memcpy(res->pointer, p+2*startBlock, sizeof(int)*res->length);
+		res->pointer[0] = first;
+		return res;
+	}
+
+	const int lastPos = limit > INT_MAX - offset ? INT_MAX : offset+limit-1;
+	int last = group_index_Select(idx, lastPos);
+	int endBlock;
+	if (last == -1)
+	{
+		// The page goes to the end of the bitstream.
+		endBlock = idx->blocks-1;
+		last = p[2*endBlock+1]-1;
+	}
+	else
+		endBlock = indexFindBlock(idx, lastPos);
+
+	const int n = 2*(endBlock-startBlock+1);
+	group_InitWithSize(res, n);
+	// The end of the last block is not read, since it is missing in
+	// an inverted bitstream.
+	memcpy(res->pointer, p+2*startBlock, sizeof(int)*(n-1));
+	res->pointer[0] = first;
+	res->pointer[n-1] = last+1;
+	return res;
+}
@@ -0,0 +1,77 @@
+//
+//  group-index.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MemGroups_group_index_h
+#define MemGroups_group_index_h
+
+	//
+	//	RANK AND SELECT
+	//
+	//	An index stores how many members there are before each block
+	//	of a bitstream. With it, the position of a member and the
+	//	member at a position are found by binary search instead of
+	//	walking through the blocks.
+	//	The index refers to the bitstream without copying it, so it
+	//	must be built again if the bitstream changes.
+	//
+	typedef struct group_index {
+		gcstack_item gc;
+		const group* bitstream;
+
+		/* Number of blocks, counting an infinite one at the end. */
+		int blocks;
+
+		/* Members before each block, with the total size at the end. */
+		int* before;
+	} group_index;
+
+	void group_index_Delete
+	(void* const p);
+
+	group_index* group_index_GcAlloc
+	(gcstack* const gc);
+
+	group_index* group_index_InitWithGroup
+	(group_index* const idx, const group* const a);
+
+	//
+	// Returns the number of members, or -1 if the bitstream is infinite.
+	//
+	int group_index_Size
+	(const group_index* const idx);
+
+	//
+	// Returns the member at position 'k', counting from 0.
+	// Returns -1 if there are not that many members.
+	//
+	int group_index_Select
+	(const group_index* const idx, const int k);
+
+	//
+	// Returns the number of members less than 'id'.
+	//
+	int group_index_Rank
+	(const group_index* const idx, const int id);
+
+	//
+	// Creates a bitstream with the members from position 'offset'
+	// and at most 'limit' members on.
+	// This is useful to show a long list of members page by page.
+	//
+	group* group_index_GcPage
+	(gcstack* const gc, const group_index* const idx,
+	 const int offset, const int limit);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
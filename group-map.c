@@ -0,0 +1,166 @@
+//
+//  group-map.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "gcstack.h"
+#include "errorhandling.h"
+#include "readability.h"
+#include "group.h"
+
+#include "group-map.h"
+
+enum {
+	GROUP_MAP_VERSION = 1,
+	GROUP_MAP_BYTE_ORDER = 0x01020304,
+	GROUP_MAP_HEADER = 4
+};
+
+const char m_groupMapMagic[4] = {'M', 'G', 'R', 'P'};
+
+void group_map_Delete(void* const p)
+{
+	macro_err_return(p == NULL);
+
+	group_map* const map = (group_map* const)p;
+
+	// Views that were changed got their own copy of the boundaries.
+	int i;
+	for (i = 0; i < map->length; i++)
+		group_Delete(map->groups + i);
+
+	if (map->data != NULL)
+		munmap(map->data, map->size);
+
+	free(map->groups);
+	map->data = NULL;
+	map->size = 0;
+	map->groups = NULL;
+	map->length = 0;
+}
+
+group_map* group_map_GcAlloc(gcstack* const gc)
+{
+	return (group_map*)gcstack_malloc
+	(gc, sizeof(group_map), group_map_Delete);
+}
+
+group_map* group_map_InitWithFile
+(group_map* const map, const char* const path)
+{
+	macro_err_return_null(map == NULL);
+	macro_err_return_null(path == NULL);
+
+	map->data = NULL;
+	map->size = 0;
+	map->length = 0;
+	map->groups = NULL;
+
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || 
+	    st.st_size < (off_t)(GROUP_MAP_HEADER*sizeof(unsigned int)))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	void* const data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+
+	map->data = data;
+	map->size = st.st_size;
+
+	const unsigned int* const words = (const unsigned int*)data;
+	const size_t n = map->size / sizeof(unsigned int);
+	const unsigned int count = words[3];
+	if (memcmp(data, m_groupMapMagic, 4) != 0 ||
+	    words[1] != GROUP_MAP_VERSION ||
+	    words[2] != GROUP_MAP_BYTE_ORDER ||
+	    count > (n - GROUP_MAP_HEADER) / 2)
+	{
+		group_map_Delete(map);
+		return NULL;
+	}
+
+	map->groups = calloc(count, sizeof(group));
+	map->length = (int)count;
+
+	const unsigned int* const table = words + GROUP_MAP_HEADER;
+	unsigned int i, offset, length;
+	for (i = 0; i < count; i++)
+	{
+		offset = table[2*i];
+		length = table[2*i+1];
+		if (offset > n || length > n - offset || length > 0x7FFFFFFF)
+		{
+			group_map_Delete(map);
+			return NULL;
+		}
+
+		map->groups[i].pointer = (int*)(words + offset);
+		map->groups[i].length = (int)length;
+		map->groups[i].readOnly = true;
+	}
+
+	return map;
+}
+
+group* group_map_Get(const group_map* const map, const int index)
+{
+	macro_err_return_null(map == NULL);
+	macro_err_return_null(index < 0 || index >= map->length);
+
+	return map->groups + index;
+}
+
+int group_map_WriteFile
+(const char* const path, const int n, const group* const* const groups)
+{
+	macro_err_return_zero(path == NULL);
+	macro_err_return_zero(n < 0);
+	macro_err_return_zero(n > 0 && groups == NULL);
+
+	FILE* const f = fopen(path, "wb");
+	if (f == NULL)
+		return false;
+
+	const unsigned int header[GROUP_MAP_HEADER-1] = {
+		GROUP_MAP_VERSION, GROUP_MAP_BYTE_ORDER, (unsigned int)n
+	};
+	int ok = fwrite(m_groupMapMagic, 1, 4, f) == 4 &&
+	fwrite(header, sizeof(unsigned int), GROUP_MAP_HEADER-1, f) == 
+	GROUP_MAP_HEADER-1;
+
+	unsigned int entry[2];
+	unsigned int offset = GROUP_MAP_HEADER + 2*n;
+	int i;
+	for (i = 0; ok && i < n; i++)
+	{
+		entry[0] = offset;
+		entry[1] = (unsigned int)groups[i]->length;
+		ok = fwrite(entry, sizeof(unsigned int), 2, f) == 2;
+		offset += entry[1];
+	}
+	for (i = 0; ok && i < n; i++)
+		if (groups[i]->length > 0)
+			ok = fwrite(groups[i]->pointer, sizeof(int), 
+				    groups[i]->length, f) == (size_t)groups[i]->length;
+
+	return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,76 @@
+//
+//  group-map.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MemGroups_group_map_h
+#define MemGroups_group_map_h
+
+	//
+	//	MEMORY MAPPED BITSTREAMS
+	//
+	//	A file of many bitstreams can be mapped into memory, and each
+	//	bitstream is then a read only view that points straight into the
+	//	mapping. Nothing is allocated or copied for the boundaries, so
+	//	opening a large file is fast and the pages are loaded as needed.
+	//
+	//	The views work as input to all operators. If a view is changed
+	//	with an in-place operator or Pop, it gets its own copy first.
+	//	The views can not be used after the map is deleted.
+	//
+	//	The file starts with a header:
+	//
+	//	"MGRP", version, byte order mark 0x01020304, number of bitstreams
+	//
+	//	followed by the offset and length of each bitstream, and then
+	//	the boundaries. All numbers are 32 bit in the byte order of the
+	//	computer that wrote the file, and the offsets count 32 bit words
+	//	from the start of the file.
+	//
+	typedef struct group_map {
+		gcstack_item gc;
+		void* data;
+		size_t size;
+		int length;
+		group* groups;
+	} group_map;
+
+	void group_map_Delete
+	(void* const p);
+
+	group_map* group_map_GcAlloc
+	(gcstack* const gc);
+
+	//
+	// Maps a file written by 'group_map_WriteFile'.
+	// Returns NULL if the file can not be opened or is not valid.
+	// The boundaries are not checked, so the file should come from
+	// a trusted source.
+	//
+	group_map* group_map_InitWithFile
+	(group_map* const map, const char* const path);
+
+	//
+	// Returns a view of a bitstream in the map.
+	//
+	group* group_map_Get
+	(const group_map* const map, const int index);
+
+	//
+	// Writes bitstreams to a file that can be mapped.
+	// Returns false if the file could not be written.
+	//
+	int group_map_WriteFile
+	(const char* const path, const int n, const group* const* const groups);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
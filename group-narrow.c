@@ -0,0 +1,248 @@
+//
+//  group-narrow.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcstack.h"
+#include "errorhandling.h"
+#include "readability.h"
+#include "merge-kernel.h"
+#include "group.h"
+
+#include "group-narrow.h"
+
+macro_merge_kernel(narrow16, unsigned short)
+
+/*
+	Narrow boundaries are widened this many at a time when merged
+	with wide boundaries.
+*/
+#define NARROW_BLOCK 256
+
+void group_narrow_Delete(void* const p)
+{
+	macro_err_return(p == NULL);
+
+	group_narrow* const a = (group_narrow* const)p;
+	free(a->pointer);
+	a->pointer = NULL;
+	a->length = 0;
+}
+
+group_narrow* group_narrow_GcAlloc(gcstack* const gc)
+{
+	return (group_narrow*)gcstack_malloc
+	(gc, sizeof(group_narrow), group_narrow_Delete);
+}
+
+int narrowWidth(const int* const p, const int n);
+
+//
+// The boundaries are sorted, so only the first and last are checked.
+//
+int narrowWidth(const int* const p, const int n)
+{
+	return n == 0 || (p[0] >= 0 && p[n-1] <= 0xFFFF) ? 2 : 4;
+}
+
+void narrowInitWithInts
+(group_narrow* const a, const int n, const int* const p);
+
+//
+// Stores the boundaries with the narrowest width.
+//
+void narrowInitWithInts
+(group_narrow* const a, const int n, const int* const p)
+{
+	a->length = n;
+	a->width = narrowWidth(p, n);
+	a->pointer = n == 0 ? NULL : malloc(a->width*n);
+	if (n == 0)
+		return;
+
+	if (a->width == 4)
+	{
+		memcpy(a->pointer, p, sizeof(int)*n);
+		return;
+	}
+
+	unsigned short* const s = (unsigned short*)a->pointer;
+	int i;
+	for (i = 0; i < n; i++)
+		s[i] = (unsigned short)p[i];
+}
+
+int narrowMergeMixed
+(const group_narrow* const a, const group_narrow* const b, 
+ const int table, int* const out);
+
+//
+// Merges a narrow and a wide bitstream with 'mergeBoundaries'.
+// The narrow boundaries are widened one block at a time, and each
+// block is merged with the wide boundaries that come before the
+// next block. The states at the start of a block are the parity of
+// the boundaries read so far.
+//
+int narrowMergeMixed
+(const group_narrow* const a, const group_narrow* const b, 
+ const int table, int* const out)
+{
+	const int narrowA = a->width == 2;
+	const group_narrow* const s = narrowA ? a : b;
+	const group_narrow* const w = narrowA ? b : a;
+	const unsigned short* const sp = (const unsigned short*)s->pointer;
+	const int* const wp = (const int*)w->pointer;
+	
+	int block[NARROW_BLOCK];
+	int i = 0, j = 0, k = 0;
+	int n, m, c;
+	do {
+		n = s->length-i < NARROW_BLOCK ? s->length-i : NARROW_BLOCK;
+		for (c = 0; c < n; c++)
+			block[c] = sp[i+c];
+		
+		// The last block takes the rest of the wide boundaries.
+		m = i+n < s->length ?
+		gallopCountLess(wp+j, w->length-j, sp[i+n]) : w->length-j;
+		
+		k += narrowA ?
+		mergeBoundaries(block, n, i & 1, wp+j, m, j & 1, table, out+k) :
+		mergeBoundaries(wp+j, m, j & 1, block, n, i & 1, table, out+k);
+		i += n;
+		j += m;
+	} while (i < s->length);
+	return k;
+}
+
+group_narrow* group_narrow_InitWithGroup
+(group_narrow* const a, const group* const b)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	narrowInitWithInts(a, b->length, b->pointer);
+	return a;
+}
+
+group* group_narrow_GcGroup(gcstack* const gc, const group_narrow* const a)
+{
+	macro_err_return_null(a == NULL);
+
+	group* const res = group_InitWithSize(group_GcAlloc(gc), a->length);
+	if (a->length == 0)
+		return res;
+
+	if (a->width == 4)
+	{
+		memcpy(res->pointer, a->pointer, sizeof(int)*a->length);
+		return res;
+	}
+
+	const unsigned short* const s = (const unsigned short*)a->pointer;
+	int i;
+	for (i = 0; i < a->length; i++)
+		res->pointer[i] = s[i];
+	return res;
+}
+
+group_narrow* narrowMerge
+(gcstack* const gc, const group_narrow* const a,
+ const group_narrow* const b, const int table);
+
+group_narrow* narrowMerge
+(gcstack* const gc, const group_narrow* const a,
+ const group_narrow* const b, const int table)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	group_narrow* const res = group_narrow_GcAlloc(gc);
+	res->width = 2;
+	const int size = a->length + b->length;
+	if (size == 0)
+		return res;
+
+	// The result of two narrow bitstreams is a subset of their
+	// boundaries, so it is narrow too.
+	if (a->width == 2 && b->width == 2)
+	{
+		unsigned short* const buff = malloc(sizeof(unsigned short)*size);
+		res->length = narrow16Merge
+		((const unsigned short*)a->pointer, a->length, false,
+		 (const unsigned short*)b->pointer, b->length, false,
+		 table, buff);
+		res->pointer = buff;
+		if (res->length == 0)
+		{
+			free(buff);
+			res->pointer = NULL;
+		}
+		else if (res->length < size)
+			res->pointer = realloc(buff, sizeof(unsigned short)*res->length);
+		return res;
+	}
+
+	int* const buff = malloc(sizeof(int)*size);
+	const int length = a->width == 4 && b->width == 4 ?
+	mergeBoundaries
+	((const int*)a->pointer, a->length, false, 
+	 (const int*)b->pointer, b->length, false, table, buff) :
+	narrowMergeMixed(a, b, table, buff);
+	narrowInitWithInts(res, length, buff);
+	free(buff);
+	return res;
+}
+
+group_narrow* group_narrow_GcAnd
+(gcstack* const gc, const group_narrow* const a,
+ const group_narrow* const b)
+{
+	return narrowMerge(gc, a, b, MERGE_AND);
+}
+
+group_narrow* group_narrow_GcOr
+(gcstack* const gc, const group_narrow* const a,
+ const group_narrow* const b)
+{
+	return narrowMerge(gc, a, b, MERGE_OR);
+}
+
+group_narrow* group_narrow_GcExcept
+(gcstack* const gc, const group_narrow* const a,
+ const group_narrow* const b)
+{
+	return narrowMerge(gc, a, b, MERGE_EXCEPT);
+}
+
+int group_narrow_Size(const group_narrow* const a)
+{
+	macro_err_return_zero(a == NULL);
+
+	long long sum = 0;
+	int i;
+	if (a->width == 2)
+	{
+		const unsigned short* const s = (const unsigned short*)a->pointer;
+		for (i = 0; i+1 < a->length; i += 2)
+			sum += s[i+1] - s[i];
+		return (int)sum;
+	}
+
+	const int* const p = (const int*)a->pointer;
+	for (i = 0; i+1 < a->length; i += 2)
+		sum += (long long)p[i+1] - p[i];
+	return sum > 0x7FFFFFFF ? 0x7FFFFFFF : (int)sum;
+}
+
+int group_narrow_Bytes(const group_narrow* const a)
+{
+	macro_err_return_zero(a == NULL);
+
+	return a->width * a->length;
+}
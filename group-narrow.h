@@ -0,0 +1,85 @@
+//
+//  group-narrow.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MemGroups_group_narrow_h
+#define MemGroups_group_narrow_h
+
+	//
+	//	NARROW BITSTREAMS
+	//
+	//	Most bitstreams refer to fewer than 65536 members, so their
+	//	boundaries fit in 16 bits. A narrow bitstream uses the smallest
+	//	width that fits all its boundaries, which halves the memory
+	//	and lets twice as many boundaries fit in the cache.
+	//
+	//	Width	Boundaries
+	//	2	0 to 65535
+	//	4	any int
+	//
+	//	The operators use a merge made for each width. When the widths
+	//	differ, the narrow one is widened while it is read, and the
+	//	result is narrowed again if it fits.
+	//
+	typedef struct group_narrow {
+		gcstack_item gc;
+		int length;
+
+		/* The number of bytes per boundary, 2 or 4. */
+		int width;
+
+		/* unsigned short* or int* depending on the width. */
+		void* pointer;
+	} group_narrow;
+
+	void group_narrow_Delete
+	(void* const p);
+
+	group_narrow* group_narrow_GcAlloc
+	(gcstack* const gc);
+
+	//
+	// Initializes from a bitstream, picking the narrowest width.
+	//
+	group_narrow* group_narrow_InitWithGroup
+	(group_narrow* const a, const group* const b);
+
+	//
+	// Creates a bitstream with int boundaries.
+	//
+	group* group_narrow_GcGroup
+	(gcstack* const gc, const group_narrow* const a);
+
+	group_narrow* group_narrow_GcAnd
+	(gcstack* const gc, const group_narrow* const a,
+	 const group_narrow* const b);
+
+	group_narrow* group_narrow_GcOr
+	(gcstack* const gc, const group_narrow* const a,
+	 const group_narrow* const b);
+
+	group_narrow* group_narrow_GcExcept
+	(gcstack* const gc, const group_narrow* const a,
+	 const group_narrow* const b);
+
+	int group_narrow_Size
+	(const group_narrow* const a);
+
+	//
+	// Returns the number of bytes used for the boundaries.
+	//
+	int group_narrow_Bytes
+	(const group_narrow* const a);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
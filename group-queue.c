@@ -0,0 +1,150 @@
+//
+//  group-queue.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcstack.h"
+#include "errorhandling.h"
+#include "readability.h"
+#include "group.h"
+
+#include "group-queue.h"
+
+void group_queue_Delete(void* const p)
+{
+	macro_err_return(p == NULL);
+
+	group_queue* const q = (group_queue* const)p;
+	free(q->pointer);
+	q->pointer = NULL;
+	q->head = 0;
+	q->length = 0;
+	q->capacity = 0;
+}
+
+group_queue* group_queue_GcAlloc(gcstack* const gc)
+{
+	return (group_queue*)gcstack_malloc
+	(gc, sizeof(group_queue), group_queue_Delete);
+}
+
+group_queue* group_queue_InitWithGroup
+(group_queue* const q, const group* const a)
+{
+	macro_err_return_null(q == NULL);
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(a->length % 2 != 0);
+
+	q->head = 0;
+	q->length = a->length;
+	q->capacity = a->length;
+	q->pointer = NULL;
+	if (a->length == 0)
+		return q;
+
+	q->pointer = malloc(sizeof(int)*a->length);
+	memcpy(q->pointer, a->pointer, sizeof(int)*a->length);
+	return q;
+}
+
+int group_queue_PopStart(group_queue* const q)
+{
+	macro_err_return_zero(q == NULL);
+
+	if (q->head >= q->length) return -1;
+
+	int* const p = q->pointer + q->head;
+	const int id = p[0]++;
+
+	// Step past the block when it is used up.
+	if (p[0] >= p[1])
+		q->head += 2;
+
+	return id;
+}
+
+int group_queue_PopEnd(group_queue* const q)
+{
+	macro_err_return_zero(q == NULL);
+
+	if (q->head >= q->length) return -1;
+
+	int* const p = q->pointer + q->length - 2;
+	const int id = --p[1];
+	if (p[1] <= p[0])
+		q->length -= 2;
+
+	return id;
+}
+
+int group_queue_IsEmpty(const group_queue* const q)
+{
+	macro_err_return_zero(q == NULL);
+
+	return q->head >= q->length;
+}
+
+void group_queue_Push(group_queue* const q, const group* const b)
+{
+	macro_err_return(q == NULL);
+	macro_err_return(b == NULL);
+	macro_err_return(b->length % 2 != 0);
+
+	if (b->length == 0) return;
+
+	// The used up boundaries are dropped only when the tail is too
+	// small for the worst case, and the buffer grows only when that
+	// is not enough either.
+	const int size = q->length - q->head + b->length;
+	if (q->capacity - q->head < size)
+	{
+		if (q->head > 0)
+		{
+			memmove(q->pointer, q->pointer + q->head, 
+				sizeof(int)*(q->length - q->head));
+			q->length -= q->head;
+			q->head = 0;
+		}
+		if (q->capacity < size)
+		{
+			q->capacity = q->capacity*2 > size ? q->capacity*2 : size;
+			q->pointer = realloc(q->pointer, sizeof(int)*q->capacity);
+		}
+	}
+
+	// The members left are a bitstream in the tail of the buffer,
+	// which has room for the merge.
+	group rest;
+	rest.length = q->length - q->head;
+	rest.capacity = q->capacity - q->head;
+	rest.pointer = q->pointer + q->head;
+	rest.readOnly = false;
+	group_OrInPlace(&rest, b);
+
+	// The merge makes a new buffer only if 'b' is in the same memory.
+	if (rest.pointer != q->pointer + q->head)
+	{
+		free(q->pointer);
+		q->pointer = rest.pointer;
+		q->head = 0;
+		q->capacity = rest.capacity;
+	}
+	q->length = q->head + rest.length;
+}
+
+group* group_queue_GcGroup(gcstack* const gc, const group_queue* const q)
+{
+	macro_err_return_null(q == NULL);
+
+	if (q->head >= q->length)
+		return group_InitWithSize(group_GcAlloc(gc), 0);
+
+	return group_InitWithValues
+	(group_GcAlloc(gc), q->length - q->head, q->pointer + q->head);
+}
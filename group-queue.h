@@ -0,0 +1,81 @@
+//
+//  group-queue.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MemGroups_group_queue_h
+#define MemGroups_group_queue_h
+
+	//
+	//	QUEUES
+	//
+	//	A queue takes members from both ends of a bitstream.
+	//	When the first block of a bitstream is used up, 'group_PopStart'
+	//	moves all the other boundaries, so emptying a fragmented
+	//	bitstream that way takes O(n^2).
+	//	A queue instead keeps the position of the first boundary in use,
+	//	so removing a block is only a step forward and popping from
+	//	either end is O(1).
+	//
+	typedef struct group_queue {
+		gcstack_item gc;
+
+		/* The boundaries in use are from 'head' up to 'length'. */
+		int head;
+		int length;
+		int capacity;
+		int* pointer;
+	} group_queue;
+
+	void group_queue_Delete
+	(void* const p);
+
+	group_queue* group_queue_GcAlloc
+	(gcstack* const gc);
+
+	//
+	// Initializes the queue with a copy of the members of a finite
+	// bitstream.
+	//
+	group_queue* group_queue_InitWithGroup
+	(group_queue* const q, const group* const a);
+
+	//
+	// Removes and returns the first member, or -1 if the queue is empty.
+	//
+	int group_queue_PopStart
+	(group_queue* const q);
+
+	//
+	// Removes and returns the last member, or -1 if the queue is empty.
+	//
+	int group_queue_PopEnd
+	(group_queue* const q);
+
+	int group_queue_IsEmpty
+	(const group_queue* const q);
+
+	//
+	// Adds the members of a finite bitstream to the queue.
+	// The boundaries that are used up are released at the same time.
+	//
+	void group_queue_Push
+	(group_queue* const q, const group* const b);
+
+	//
+	// Creates a bitstream with the members left in the queue.
+	//
+	group* group_queue_GcGroup
+	(gcstack* const gc, const group_queue* const q);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,717 @@
+//
+//  group-serialize.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "gcstack.h"
+#include "errorhandling.h"
+#include "readability.h"
+#include "group.h"
+#include "merge-kernel.h"
+
+#include "group-serialize.h"
+
+int writeVarint(unsigned char* const out, unsigned int v);
+
+//
+// Writes 7 bits at a time, lowest first.
+// Returns the number of bytes, and writes nothing if 'out' is NULL.
+//
+int writeVarint(unsigned char* const out, unsigned int v)
+{
+	int n = 0;
+	while (v >= 0x80)
+	{
+		if (out != NULL) out[n] = (unsigned char)(v | 0x80);
+		n++;
+		v >>= 7;
+	}
+	if (out != NULL) out[n] = (unsigned char)v;
+	return n+1;
+}
+
+int readVarint
+(const unsigned char** const pos, const unsigned char* const end,
+ unsigned int* const v);
+
+//
+// Returns false if the varint goes beyond the data or 32 bits.
+//
+int readVarint
+(const unsigned char** const pos, const unsigned char* const end,
+ unsigned int* const v)
+{
+	const unsigned char* p = *pos;
+	unsigned int res = 0;
+	int shift;
+	for (shift = 0; shift < 35; shift += 7)
+	{
+		if (p == end)
+			return false;
+		res |= (unsigned int)(*p & 0x7F) << shift;
+		if ((*p++ & 0x80) == 0)
+		{
+			if (shift == 28 && (p[-1] & 0x70) != 0)
+				return false;
+			*v = res;
+			*pos = p;
+			return true;
+		}
+	}
+	return false;
+}
+
+void writeInt32(unsigned char* const out, const unsigned int v);
+
+void writeInt32(unsigned char* const out, const unsigned int v)
+{
+	out[0] = (unsigned char)v;
+	out[1] = (unsigned char)(v >> 8);
+	out[2] = (unsigned char)(v >> 16);
+	out[3] = (unsigned char)(v >> 24);
+}
+
+unsigned int readInt32(const unsigned char* const p);
+
+unsigned int readInt32(const unsigned char* const p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8) |
+	((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+//
+// The first boundary can be negative, so it is zigzag encoded to keep
+// small negative numbers short.
+//
+#define macro_zigzag(x) (((unsigned int)(x) << 1) ^ (unsigned int)((x) >> 31))
+#define macro_unzigzag(u) ((int)((u) >> 1) ^ -(int)((u) & 1))
+
+//
+// The boundaries are increasing, so the difference minus one is stored.
+//
+#define macro_delta(prev, next) ((unsigned int)(next) - (unsigned int)(prev) - 1)
+
+int serializeBlocks
+(const int* const p, const int len, unsigned char* const out);
+
+int serializeBlocks
+(const int* const p, const int len, unsigned char* const out)
+{
+	int size = 0;
+	int i, j, count, width;
+	unsigned int maxDelta, d;
+	unsigned char* dest;
+	for (i = 0; i < len; i += count)
+	{
+		count = len-i < GROUP_BLOCK_SIZE ? len-i : GROUP_BLOCK_SIZE;
+		maxDelta = 0;
+		for (j = i+1; j < i+count; j++)
+		{
+			d = macro_delta(p[j-1], p[j]);
+			if (d > maxDelta) maxDelta = d;
+		}
+		width = maxDelta < 0x100 ? 1 : maxDelta < 0x10000 ? 2 : 4;
+
+		if (out != NULL)
+		{
+			dest = out+size;
+			dest[0] = (unsigned char)width;
+			dest[1] = (unsigned char)(count-1);
+			writeInt32(dest+2, (unsigned int)p[i]);
+			writeInt32(dest+6, (unsigned int)p[i+count-1]);
+			dest += GROUP_BLOCK_HEADER;
+			for (j = i+1; j < i+count; j++)
+			{
+				d = macro_delta(p[j-1], p[j]);
+				switch (width)
+				{
+					case 1: *dest++ = (unsigned char)d; break;
+					case 2:
+						dest[0] = (unsigned char)d;
+						dest[1] = (unsigned char)(d >> 8);
+						dest += 2;
+						break;
+					default: writeInt32(dest, d); dest += 4; break;
+				}
+			}
+		}
+
+		size += GROUP_BLOCK_HEADER + (count-1)*width;
+	}
+	return size;
+}
+
+int group_Serialize
+(const group* const a, const int encoding, unsigned char* const out)
+{
+	macro_err_return_zero(a == NULL);
+	macro_err_return_zero(encoding != GROUP_ENCODING_VARINT &&
+			      encoding != GROUP_ENCODING_BLOCKS);
+
+	const int* const p = a->pointer;
+	const int len = a->length;
+	int size = 1;
+	if (out != NULL) out[0] = (unsigned char)encoding;
+	size += writeVarint(out == NULL ? NULL : out+size, (unsigned int)len);
+	if (len == 0)
+		return size;
+
+	if (encoding == GROUP_ENCODING_BLOCKS)
+		return size + serializeBlocks(p, len, out == NULL ? NULL : out+size);
+
+	size += writeVarint(out == NULL ? NULL : out+size, macro_zigzag(p[0]));
+	int i;
+	for (i = 1; i < len; i++)
+		size += writeVarint(out == NULL ? NULL : out+size,
+				    macro_delta(p[i-1], p[i]));
+	return size;
+}
+
+int group_reader_Init
+(group_reader* const r, const int size, const unsigned char* const data)
+{
+	macro_err_return_zero(r == NULL);
+	macro_err_return_zero(size < 0);
+	macro_err_return_zero(size > 0 && data == NULL);
+
+	r->pos = data;
+	r->end = data+size;
+	r->read = 0;
+	r->value = 0;
+	r->blockLength = 0;
+	r->blockRead = 0;
+	r->length = 0;
+	if (size < 1)
+		return false;
+
+	r->encoding = *r->pos++;
+	unsigned int length;
+	if (!readVarint(&r->pos, r->end, &length) || length > INT_MAX)
+		return false;
+
+	// Check the length against the data before anything is allocated.
+	const long long bytes = r->end - r->pos;
+	switch (r->encoding)
+	{
+		case GROUP_ENCODING_VARINT:
+			if (length > bytes)
+				return false;
+			break;
+		case GROUP_ENCODING_BLOCKS:
+			if (length > bytes / GROUP_BLOCK_HEADER * GROUP_BLOCK_SIZE)
+				return false;
+			break;
+		default:
+			return false;
+	}
+
+	r->length = (int)length;
+	return true;
+}
+
+long long blockLast
+(const unsigned char* p, const int width, const int count, const int first);
+
+//
+// Adds up the deltas of a block without writing the boundaries.
+// Every delta is stored minus one, so the sum grows with each step.
+//
+long long blockLast
+(const unsigned char* p, const int width, const int count, const int first)
+{
+	long long v = first;
+	int i;
+	switch (width)
+	{
+		case 1:
+			for (i = 1; i < count; i++)
+				v += (long long)p[i-1] + 1;
+			break;
+		case 2:
+			for (i = 1; i < count; i++, p += 2)
+				v += (long long)(p[0] | (p[1] << 8)) + 1;
+			break;
+		default:
+			for (i = 1; i < count; i++, p += 4)
+				v += (long long)readInt32(p) + 1;
+			break;
+	}
+	return v;
+}
+
+int readerDecodeBlock(group_reader* const r, int* const out);
+
+//
+// Decodes the next block to 'out' and returns the number of boundaries,
+// or -1 if the block is broken.
+//
+int readerDecodeBlock(group_reader* const r, int* const out)
+{
+	if (r->end - r->pos < GROUP_BLOCK_HEADER)
+		return -1;
+
+	const unsigned char* p = r->pos;
+	const int width = p[0];
+	const int count = p[1]+1;
+	const int first = (int)readInt32(p+2);
+	const int last = (int)readInt32(p+6);
+	if ((width != 1 && width != 2 && width != 4) ||
+	    count > GROUP_BLOCK_SIZE || count > r->length - r->read ||
+	    (r->read > 0 && first <= r->value) ||
+	    r->end - r->pos < GROUP_BLOCK_HEADER + (count-1)*width)
+		return -1;
+
+	p += GROUP_BLOCK_HEADER;
+	long long v = first;
+	int i;
+	out[0] = first;
+	switch (width)
+	{
+		case 1:
+			for (i = 1; i < count; i++)
+				out[i] = (int)(v += (long long)p[i-1] + 1);
+			break;
+		case 2:
+			for (i = 1; i < count; i++, p += 2)
+				out[i] = (int)(v += (long long)(p[0] | (p[1] << 8)) + 1);
+			break;
+		default:
+			for (i = 1; i < count; i++, p += 4)
+				out[i] = (int)(v += (long long)readInt32(p) + 1);
+			break;
+	}
+
+	// The header repeats the last boundary, which catches broken data
+	// and overflow.
+	if (v != last)
+		return -1;
+
+	r->pos += GROUP_BLOCK_HEADER + (count-1)*width;
+	r->read += count;
+	r->value = last;
+	return count;
+}
+
+int readerNextVarint(group_reader* const r, int* const value);
+
+int readerNextVarint(group_reader* const r, int* const value)
+{
+	unsigned int u;
+	if (!readVarint(&r->pos, r->end, &u))
+		return false;
+
+	if (r->read == 0)
+		r->value = macro_unzigzag(u);
+	else
+	{
+		if ((long long)r->value + u + 1 > INT_MAX)
+			return false;
+		r->value = (int)((long long)r->value + u + 1);
+	}
+
+	r->read++;
+	*value = r->value;
+	return true;
+}
+
+int group_reader_Next(group_reader* const r, int* const value)
+{
+	macro_err_return_zero(r == NULL);
+	macro_err_return_zero(value == NULL);
+
+	if (r->blockRead < r->blockLength)
+	{
+		*value = r->block[r->blockRead++];
+		return true;
+	}
+	if (r->read >= r->length)
+		return false;
+
+	if (r->encoding == GROUP_ENCODING_VARINT)
+		return readerNextVarint(r, value);
+
+	const int n = readerDecodeBlock(r, r->block);
+	if (n <= 0)
+		return false;
+
+	r->blockLength = n;
+	r->blockRead = 1;
+	*value = r->block[0];
+	return true;
+}
+
+int group_reader_NextBlock(group_reader* const r, int* const out)
+{
+	macro_err_return_zero(r == NULL);
+	macro_err_return_zero(out == NULL);
+
+	int n = 0;
+	if (r->blockRead < r->blockLength)
+	{
+		// Finish the block that was started by 'Next'.
+		n = r->blockLength - r->blockRead;
+		memcpy(out, r->block + r->blockRead, sizeof(int)*n);
+		r->blockRead = r->blockLength;
+		return n;
+	}
+	if (r->read >= r->length)
+		return 0;
+
+	if (r->encoding == GROUP_ENCODING_BLOCKS)
+		return readerDecodeBlock(r, out);
+
+	while (n < GROUP_BLOCK_SIZE && r->read < r->length)
+	{
+		if (!readerNextVarint(r, out+n))
+			return -1;
+		n++;
+	}
+	return n;
+}
+
+group* group_Deserialize
+(group* const a, const int size, const unsigned char* const data)
+{
+	macro_err_return_null(a == NULL);
+
+	group_reader r;
+	if (!group_reader_Init(&r, size, data))
+		return NULL;
+
+	group_InitWithSize(a, r.length);
+	int k = 0, n;
+	while (k < r.length)
+	{
+		n = group_reader_NextBlock(&r, a->pointer+k);
+		if (n <= 0)
+		{
+			group_Delete(a);
+			return NULL;
+		}
+		k += n;
+	}
+
+	return a;
+}
+
+//
+//	OPERATIONS ON SERIALIZED BITSTREAMS
+//
+
+//
+// Reads one input of an operation. A block is either decoded into
+// 'buf', or only its header is read so it can be copied or skipped.
+//
+typedef struct serialized_cursor {
+	group_reader r;
+	int buf[GROUP_BLOCK_SIZE];
+	int n;
+	int i;
+	int raw;
+	int first;
+	int last;
+	int count;
+	int bytes;
+	int done;
+} serialized_cursor;
+
+int cursorFill(serialized_cursor* const c);
+
+//
+// Makes sure there is a value or a block header to look at.
+// Returns false if the data is broken.
+//
+int cursorFill(serialized_cursor* const c)
+{
+	if (c->i < c->n || c->raw || c->done)
+		return true;
+
+	if (c->r.read >= c->r.length)
+	{
+		c->done = true;
+		return true;
+	}
+
+	if (c->r.encoding == GROUP_ENCODING_VARINT)
+	{
+		c->n = group_reader_NextBlock(&c->r, c->buf);
+		c->i = 0;
+		return c->n > 0;
+	}
+
+	const unsigned char* const p = c->r.pos;
+	if (c->r.end - p < GROUP_BLOCK_HEADER)
+		return false;
+
+	const int width = p[0];
+	c->count = p[1]+1;
+	c->first = (int)readInt32(p+2);
+	c->last = (int)readInt32(p+6);
+	c->bytes = GROUP_BLOCK_HEADER + (c->count-1)*width;
+	if ((width != 1 && width != 2 && width != 4) ||
+	    c->count > GROUP_BLOCK_SIZE ||
+	    c->count > c->r.length - c->r.read || c->first > c->last ||
+	    (c->r.read > 0 && c->first <= c->r.value) ||
+	    c->r.end - p < c->bytes)
+		return false;
+
+	// A block that is copied or skipped is never decoded, so the deltas
+	// are checked against the last boundary like 'readerDecodeBlock' does.
+	if (blockLast(p + GROUP_BLOCK_HEADER, width, c->count, c->first) != 
+	    c->last)
+		return false;
+
+	c->raw = true;
+	return true;
+}
+
+int cursorDecode(serialized_cursor* const c);
+
+int cursorDecode(serialized_cursor* const c)
+{
+	c->raw = false;
+	c->n = readerDecodeBlock(&c->r, c->buf);
+	c->i = 0;
+	return c->n > 0;
+}
+
+//
+// The next boundary, which is the first in the block if not decoded.
+//
+#define macro_cursor_next(c) ((c)->i < (c)->n ? (c)->buf[(c)->i] : (c)->first)
+
+//
+// Collects the result and encodes it block by block.
+//
+typedef struct serialized_writer {
+	unsigned char* data;
+	int size;
+	int capacity;
+	int length;
+	int pending[GROUP_BLOCK_SIZE];
+	int n;
+} serialized_writer;
+
+void writerReserve(serialized_writer* const w, const int bytes);
+
+void writerReserve(serialized_writer* const w, const int bytes)
+{
+	if (w->size + bytes <= w->capacity)
+		return;
+
+	w->capacity = w->capacity*2 > w->size + bytes ? 
+	w->capacity*2 : w->size + bytes;
+	w->data = realloc(w->data, w->capacity);
+}
+
+void writerFlush(serialized_writer* const w);
+
+void writerFlush(serialized_writer* const w)
+{
+	if (w->n == 0)
+		return;
+
+	writerReserve(w, GROUP_BLOCK_HEADER + (w->n-1)*4);
+	w->size += serializeBlocks(w->pending, w->n, w->data + w->size);
+	w->length += w->n;
+	w->n = 0;
+}
+
+void writerAdd(serialized_writer* const w, const int value);
+
+void writerAdd(serialized_writer* const w, const int value)
+{
+	w->pending[w->n++] = value;
+	if (w->n == GROUP_BLOCK_SIZE)
+		writerFlush(w);
+}
+
+void writerCopyBlock
+(serialized_writer* const w, const serialized_cursor* const c);
+
+//
+// Blocks store their first boundary as it is, so a block can be copied
+// without decoding it.
+//
+void writerCopyBlock
+(serialized_writer* const w, const serialized_cursor* const c)
+{
+	writerFlush(w);
+	writerReserve(w, c->bytes);
+	memcpy(w->data + w->size, c->r.pos, c->bytes);
+	w->size += c->bytes;
+	w->length += c->count;
+}
+
+void cursorSkipBlock(serialized_cursor* const c);
+
+void cursorSkipBlock(serialized_cursor* const c)
+{
+	c->r.pos += c->bytes;
+	c->r.read += c->count;
+	c->r.value = c->last;
+	c->raw = false;
+}
+
+unsigned char* serializedMerge
+(const int sizeA, const unsigned char* const a,
+ const int sizeB, const unsigned char* const b,
+ const int table, int* const size);
+
+//
+// Walks through both inputs like 'mergeBoundaries' in group.c.
+// When a whole block of one input comes before the next boundary in
+// the other, the state of the other is the same for the whole block,
+// so the block is either copied as it is or skipped without decoding.
+// Only blocks that overlap are decoded.
+//
+unsigned char* serializedMerge
+(const int sizeA, const unsigned char* const a,
+ const int sizeB, const unsigned char* const b,
+ const int table, int* const size)
+{
+	const int changesA[2] = {
+		macro_merge_value(table, 0, 0) != 
+		macro_merge_value(table, 1, 0),
+		macro_merge_value(table, 0, 1) != 
+		macro_merge_value(table, 1, 1)
+	};
+	const int changesB[2] = {
+		macro_merge_value(table, 0, 0) != 
+		macro_merge_value(table, 0, 1),
+		macro_merge_value(table, 1, 0) != 
+		macro_merge_value(table, 1, 1)
+	};
+
+	serialized_cursor* const A = calloc(2, sizeof(serialized_cursor));
+	serialized_cursor* const B = A+1;
+	serialized_writer w;
+	w.data = NULL;
+	w.size = 0;
+	w.capacity = 0;
+	w.length = 0;
+	w.n = 0;
+
+	int ba = false, bb = false;
+	int ok = group_reader_Init(&A->r, sizeA, a) && 
+	group_reader_Init(&B->r, sizeB, b);
+	int pa, pb;
+	while (ok)
+	{
+		if (!cursorFill(A) || !cursorFill(B))
+		{
+			ok = false;
+			break;
+		}
+		if (A->done && B->done)
+			break;
+
+		// Copy or skip blocks that do not overlap the other input.
+		if (A->raw && (B->done || A->last < macro_cursor_next(B)))
+		{
+			if (changesA[bb])
+				writerCopyBlock(&w, A);
+			ba ^= A->count & 1;
+			cursorSkipBlock(A);
+			continue;
+		}
+		if (B->raw && (A->done || B->last < macro_cursor_next(A)))
+		{
+			if (changesB[ba])
+				writerCopyBlock(&w, B);
+			bb ^= B->count & 1;
+			cursorSkipBlock(B);
+			continue;
+		}
+
+		// Decode the block with the next boundary.
+		pa = A->done ? 0 : macro_cursor_next(A);
+		pb = B->done ? 0 : macro_cursor_next(B);
+		if (A->raw && (B->done || pa <= pb))
+			ok = cursorDecode(A);
+		if (ok && B->raw && (A->done || pb <= pa))
+			ok = cursorDecode(B);
+		if (!ok)
+			break;
+
+		if (!A->done && (B->done || pa < pb))
+		{
+			if (changesA[bb])
+				writerAdd(&w, pa);
+			ba = !ba;
+			A->i++;
+		}
+		else if (!B->done && (A->done || pb < pa))
+		{
+			if (changesB[ba])
+				writerAdd(&w, pb);
+			bb = !bb;
+			B->i++;
+		}
+		else
+		{
+			if (macro_merge_value(table, ba, bb) != 
+			    macro_merge_value(table, !ba, !bb))
+				writerAdd(&w, pa);
+			ba = !ba;
+			bb = !bb;
+			A->i++;
+			B->i++;
+		}
+	}
+
+	free(A);
+	if (!ok)
+	{
+		free(w.data);
+		return NULL;
+	}
+
+	writerFlush(&w);
+
+	// The length is known now, so the header is put in front.
+	const int header = 1 + writeVarint(NULL, (unsigned int)w.length);
+	unsigned char* const res = malloc(header + w.size);
+	res[0] = GROUP_ENCODING_BLOCKS;
+	writeVarint(res+1, (unsigned int)w.length);
+	if (w.size > 0)
+		memcpy(res + header, w.data, w.size);
+	free(w.data);
+
+	*size = header + w.size;
+	return res;
+}
+
+unsigned char* group_SerializedAnd
+(const int sizeA, const unsigned char* const a,
+ const int sizeB, const unsigned char* const b, int* const size)
+{
+	macro_err_return_null(size == NULL);
+
+	return serializedMerge(sizeA, a, sizeB, b, MERGE_AND, size);
+}
+
+unsigned char* group_SerializedOr
+(const int sizeA, const unsigned char* const a,
+ const int sizeB, const unsigned char* const b, int* const size)
+{
+	macro_err_return_null(size == NULL);
+
+	return serializedMerge(sizeA, a, sizeB, b, MERGE_OR, size);
+}
+
+unsigned char* group_SerializedExcept
+(const int sizeA, const unsigned char* const a,
+ const int sizeB, const unsigned char* const b, int* const size)
+{
+	macro_err_return_null(size == NULL);
+
+	return serializedMerge(sizeA, a, sizeB, b, MERGE_EXCEPT, size);
+}
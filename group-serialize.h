@@ -0,0 +1,134 @@
+//
+//  group-serialize.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MemGroups_group_serialize_h
+#define MemGroups_group_serialize_h
+
+	//
+	//	SERIALIZATION
+	//
+	//	The boundaries of a bitstream are increasing, so they are
+	//	stored as the difference to the previous one.
+	//	Most differences are small and fit in one or two bytes.
+	//
+	//	There are two encodings:
+	//
+	//	VARINT	Each difference uses 7 bits per byte, with the high bit
+	//		telling whether another byte follows.
+	//		This is the smallest.
+	//
+	//	BLOCKS	The boundaries are split into blocks of up to
+	//		GROUP_BLOCK_SIZE. Each block has a header with its first
+	//		and last boundary and the width of the differences,
+	//		which are stored with 1, 2 or 4 bytes each.
+	//		The fixed width makes it fast to decode a whole block,
+	//		and the header makes it possible to skip blocks.
+	//
+	//	All numbers are stored in little endian byte order.
+	//
+	enum {
+		GROUP_ENCODING_VARINT = 1,
+		GROUP_ENCODING_BLOCKS = 2,
+		GROUP_BLOCK_SIZE = 128,
+		GROUP_BLOCK_HEADER = 10
+	};
+
+	//
+	// Writes the bitstream to 'out' and returns the number of bytes.
+	// If 'out' is NULL, nothing is written, which is used to find
+	// how much room is needed.
+	//
+	int group_Serialize
+	(const group* const a, const int encoding, unsigned char* const out);
+
+	//
+	// Initializes a bitstream from serialized data.
+	// Returns NULL if the data is not a valid bitstream.
+	//
+	group* group_Deserialize
+	(group* const a, const int size, const unsigned char* const data);
+
+	//
+	//	STREAMING
+	//
+	//	A reader decodes the boundaries one by one or block by block,
+	//	without creating the whole bitstream.
+	//
+	typedef struct group_reader {
+		const unsigned char* pos;
+		const unsigned char* end;
+		int encoding;
+
+		/* The total number of boundaries. */
+		int length;
+
+		/* The number of boundaries read so far. */
+		int read;
+
+		/* The last boundary read. */
+		int value;
+
+		/* The decoded boundaries of the current block. */
+		int block[GROUP_BLOCK_SIZE];
+		int blockLength;
+		int blockRead;
+	} group_reader;
+
+	//
+	// Starts reading serialized data.
+	// Returns false if the data does not start with a valid header.
+	//
+	int group_reader_Init
+	(group_reader* const r, const int size, const unsigned char* const data);
+
+	//
+	// Reads the next boundary.
+	// Returns false when there are no more, or the data is broken.
+	//
+	int group_reader_Next
+	(group_reader* const r, int* const value);
+
+	//
+	// Reads up to GROUP_BLOCK_SIZE boundaries into 'out' and returns
+	// the number read, or -1 if the data is broken.
+	//
+	int group_reader_NextBlock
+	(group_reader* const r, int* const out);
+
+	//
+	//	OPERATIONS ON SERIALIZED BITSTREAMS
+	//
+	//	These compute And, Or and Except directly from serialized data
+	//	and return the result in the BLOCKS encoding, allocated with
+	//	malloc. The size in bytes is written to 'size'.
+	//	Blocks that do not overlap a block in the other input are
+	//	copied or skipped by looking at the header only, so large
+	//	bitstreams can stay compressed and still be queried.
+	//	Either encoding is accepted as input, but only BLOCKS can be
+	//	skipped. Returns NULL if the data is broken.
+	//
+	unsigned char* group_SerializedAnd
+	(const int sizeA, const unsigned char* const a,
+	 const int sizeB, const unsigned char* const b, int* const size);
+
+	unsigned char* group_SerializedOr
+	(const int sizeA, const unsigned char* const a,
+	 const int sizeB, const unsigned char* const b, int* const size);
+
+	unsigned char* group_SerializedExcept
+	(const int sizeA, const unsigned char* const a,
+	 const int sizeB, const unsigned char* const b, int* const size);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -36,12 +36,17 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <unistd.h>
 
 #include <pthread.h>
 
 #include "gcstack.h"
 #include "errorhandling.h"
 #include "readability.h"
+#include "simd.h"
+#include "merge-kernel.h"
 
 #include "group.h"
 
@@ -51,13 +56,14 @@ void group_Delete(void* const p)
 	
 	group* const a = (group* const)p;
 	
-	if (a != NULL && a->pointer != NULL)
-	{
+	// Read only views refer to memory owned by someone else.
+	if (a->pointer != NULL && !a->readOnly)
 		free(a->pointer);
-		a->pointer = NULL;
-	}
 	
+	a->pointer = NULL;
 	a->length = 0;
+	a->capacity = 0;
+	a->readOnly = false;
 }
 
 group* group_GcAlloc(gcstack* const gc) 
@@ -72,6 +78,8 @@ group* group_InitWithSize(group* const a, const int size)
 	macro_err_return_null(size < 0);
 	
 	a->pointer = NULL;
+	a->capacity = 0;
+	a->readOnly = false;
 	
 	if (size == 0)
 	{
@@ -81,6 +89,7 @@ group* group_InitWithSize(group* const a, const int size)
 	}
 	
 	a->length = size;
+	a->capacity = size;
 	
 	if (size == 0) 
 		return a;
@@ -106,6 +115,8 @@ group* group_InitWithValues
 	
 	a->pointer = NULL;
 	a->length = size;
+	a->capacity = size;
+	a->readOnly = false;
 	
 	if (size == 0) return a;
 	
@@ -188,6 +199,8 @@ group* group_InitWithIndices
 	macro_err_return_null(vals == NULL);
 	
 	a->pointer = NULL;
+	a->capacity = 0;
+	a->readOnly = false;
 	
 	if (size == 0) {
 		a->length = 0;
@@ -195,132 +208,346 @@ group* group_InitWithIndices
 	}
 	
 	a->length = countWithIndices(size, vals);
+	a->capacity = a->length;
 	a->pointer = createArrayFromIndices(a->length, size, vals);
 	return a;
 }
 
+void boundariesReserve(group* const a, const int extra);
+
+//
+// Makes room for 'extra' more boundaries, doubling the capacity so
+// the total cost of growing stays linear.
+//
+void boundariesReserve(group* const a, const int extra)
+{
+	if (a->length + extra <= a->capacity)
+		return;
+	
+	int capacity = a->capacity < 64 ? 64 : a->capacity;
+	while (capacity < a->length + extra)
+		capacity = capacity > INT_MAX/2 ? INT_MAX : capacity*2;
+	a->pointer = realloc(a->pointer, sizeof(int)*capacity);
+	a->capacity = capacity;
+}
+
+void boundariesFinish(group* const a, const int end);
+
+//
+// Aligns the bitstream so it becomes finite and shrinks the buffer.
+//
+void boundariesFinish(group* const a, const int end)
+{
+	if (a->length % 2 != 0)
+	{
+		boundariesReserve(a, 1);
+		a->pointer[a->length++] = end;
+	}
+	
+	if (a->length == 0)
+	{
+		free(a->pointer);
+		a->pointer = NULL;
+		a->capacity = 0;
+	}
+	else if (a->length < a->capacity)
+	{
+		a->pointer = realloc(a->pointer, sizeof(int)*a->length);
+		a->capacity = a->length;
+	}
+}
+
 group* group_InitWithFunction
 (group* const a, const int arrc, const int stride, 
  const void* const arrv, 
  int (*const f)(const void* const p))
 {
-	// The theoretical maximum is twice the size of array.
-	int buff[arrc*2];
-	int v = 0;
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(arrc < 0);
+	macro_err_return_null(f == NULL);
+	
+	// The buffer grows on the heap, because the theoretical maximum
+	// of twice the size of array does not fit on the stack.
+	a->length = 0;
+	a->capacity = 0;
+	a->pointer = NULL;
+	a->readOnly = false;
+	
+	int v = false;
 	int tmp;
 	int i;
-	int j = 0;
 	const byte* const arrb = (const byte* const)arrv;
 	
 	for (i = 0; i < arrc; i++) {
-		tmp = f(arrb+i*stride);
+		tmp = f(arrb+i*stride) != 0;
 		
 		// Log changes in the bitstream.
 		if (tmp != v) {
-			buff[j++] = i;
+			boundariesReserve(a, 1);
+			a->pointer[a->length++] = i;
 		}
 		
 		v = tmp;
 	}
 	
-	// Align the bitstream so it becomes finite.
-	if (j % 2 > 0)
-		buff[j++] = i;
-	
-	// Copy data from buffer.
-	a->length = j;
-	a->pointer = malloc(j*sizeof(int));
-	memcpy(a->pointer, buff, j*sizeof(int));
-	
+	boundariesFinish(a, arrc);
 	return a;
 }
 
-int countDeltaDouble
-(const int n, const double* const old, const double* const new);
+/*
+	The columns are scanned in chunks of this many 64 bit words,
+	so the mask stays in the cache between the scan and the boundaries.
+*/
+#define PREDICATE_CHUNK_WORDS 64
+#define PREDICATE_CHUNK (PREDICATE_CHUNK_WORDS*64)
+
+void predicateAppend
+(group* const a, unsigned long long* const words, const int count, 
+ const int base, const int invert, int* const state);
 
-int countDeltaDouble
-(const int n, const double* const old, const double* const new)
+//
+// Adds the boundaries of a chunk of mask words for 'count' values
+// starting at member 'base'. A boundary is where a bit differs from
+// the one before it, and 'state' carries the last bit between chunks.
+// Words without changes are skipped with a single compare.
+//
+void predicateAppend
+(group* const a, unsigned long long* const words, const int count, 
+ const int base, const int invert, int* const state)
 {
-	int count = 0;
-	int was = false;
-	int is;
+	const int n = (count+63)/64;
 	int i;
-	for (i = 0; i < n; i++) {
-		is = new[i] != old[i];
-		if (was != is)
-			count++;
-		was = is;
+	if (invert)
+	{
+		for (i = 0; i < n; i++)
+			words[i] = ~words[i];
+		if (count % 64 != 0)
+			words[n-1] &= ~0ULL >> (64 - count % 64);
 	}
-	if (was) {
-		count++;
+	
+	unsigned long long w, changes;
+	unsigned long long carry = *state;
+	for (i = 0; i < n; i++)
+	{
+		w = words[i];
+		if (w == (carry ? ~0ULL : 0ULL))
+			continue;
+		
+		changes = w ^ ((w << 1) | carry);
+		carry = w >> 63;
+		boundariesReserve(a, __builtin_popcountll(changes));
+		while (changes != 0)
+		{
+			a->pointer[a->length++] = base + (i << 6) + 
+			__builtin_ctzll(changes);
+			changes &= changes - 1;
+		}
 	}
-	return count;
+	
+	// Only the last chunk can end inside a word. The bits after the
+	// last value are cleared, which closes a block open at the end.
+	*state = (int)carry;
 }
 
-int countDeltaInt(const int n, const int* const old, const int* const new);
+group* predicateInitWithRangeInt
+(group* const a, const int n, const int* const column, 
+ const int lo, const int hi, const int invert);
 
-int countDeltaInt(const int n, const int* const old, const int* const new)
+group* predicateInitWithRangeInt
+(group* const a, const int n, const int* const column, 
+ const int lo, const int hi, const int invert)
 {
-	int count = 0;
-	int was = false;
-	int is;
-	int i;
-	for (i = 0; i < n; i++) {
-		is = new[i] != old[i];
-		if (was != is)
-			count++;
-		was = is;
-	}
-	if (was) {
-		count++;
+	a->length = 0;
+	a->capacity = 0;
+	a->pointer = NULL;
+	a->readOnly = false;
+	
+	unsigned long long words[PREDICATE_CHUNK_WORDS];
+	int state = false;
+	int i, count;
+	for (i = 0; i < n; i += PREDICATE_CHUNK)
+	{
+		count = n-i < PREDICATE_CHUNK ? n-i : PREDICATE_CHUNK;
+		simd_RangeMaskInt(column+i, count, lo, hi, words);
+		predicateAppend(a, words, count, i, invert, &state);
 	}
-	return count;
+	
+	boundariesFinish(a, n);
+	return a;
 }
 
-int countDeltaBool
-(const int n, const int* const old, const int* const new);
+group* predicateInitWithRangeDouble
+(group* const a, const int n, const double* const column, 
+ const double lo, const double hi, const int invert);
 
-int countDeltaBool
-(const int n, const int* const old, const int* const new)
+group* predicateInitWithRangeDouble
+(group* const a, const int n, const double* const column, 
+ const double lo, const double hi, const int invert)
 {
-	int count = 0;
-	int was = false;
-	int is;
-	int i;
-	for (i = 0; i < n; i++) {
-		is = new[i] != old[i];
-		if (was != is)
-			count++;
-		was = is;
+	a->length = 0;
+	a->capacity = 0;
+	a->pointer = NULL;
+	a->readOnly = false;
+	
+	unsigned long long words[PREDICATE_CHUNK_WORDS];
+	int state = false;
+	int i, count;
+	for (i = 0; i < n; i += PREDICATE_CHUNK)
+	{
+		count = n-i < PREDICATE_CHUNK ? n-i : PREDICATE_CHUNK;
+		simd_RangeMaskDouble(column+i, count, lo, hi, words);
+		predicateAppend(a, words, count, i, invert, &state);
 	}
-	if (was) {
-		count++;
+	
+	boundariesFinish(a, n);
+	return a;
+}
+
+group* group_InitWithIntCompare
+(group* const a, const int n, const int* const column, 
+ const int op, const int value)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && column == NULL);
+	
+	// Every compare is a range, where an empty range has lo > hi.
+	switch (op) {
+		case GROUP_LESS:
+			return value == INT_MIN ?
+			predicateInitWithRangeInt(a, n, column, 1, 0, false) :
+			predicateInitWithRangeInt(a, n, column, INT_MIN, value-1, false);
+		case GROUP_LESS_OR_EQUAL:
+			return predicateInitWithRangeInt
+			(a, n, column, INT_MIN, value, false);
+		case GROUP_EQUAL:
+			return predicateInitWithRangeInt(a, n, column, value, value, false);
+		case GROUP_NOT_EQUAL:
+			return predicateInitWithRangeInt(a, n, column, value, value, true);
+		case GROUP_GREATER_OR_EQUAL:
+			return predicateInitWithRangeInt
+			(a, n, column, value, INT_MAX, false);
+		case GROUP_GREATER:
+			return value == INT_MAX ?
+			predicateInitWithRangeInt(a, n, column, 1, 0, false) :
+			predicateInitWithRangeInt(a, n, column, value+1, INT_MAX, false);
 	}
-	return count;
+	
+	macro_err_return_null(true);
 }
 
-int countDeltaString
-(const int n, const string* const old, const string* const new);
+group* group_InitWithIntRange
+(group* const a, const int n, const int* const column, 
+ const int min, const int max)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && column == NULL);
+	
+	return predicateInitWithRangeInt(a, n, column, min, max, false);
+}
 
-int countDeltaString
-(const int n, const string* const old, const string* const new)
+group* group_InitWithDoubleCompare
+(group* const a, const int n, const double* const column, 
+ const int op, const double value)
 {
-	int counter = 0;
-	int was = false;
-	int is;
-	int i;
-	for (i = 0; i < n; i++) {
-		is = strcmp(new[i], old[i]) != 0;
-		if (was != is)
-			counter++;
-		was = is;
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && column == NULL);
+	
+	// The strict compares use the next double past 'value'.
+	// Nothing is past an infinity, so those ranges are empty.
+	switch (op) {
+		case GROUP_LESS:
+			return value == -INFINITY ?
+			predicateInitWithRangeDouble(a, n, column, 1, 0, false) :
+			predicateInitWithRangeDouble
+			(a, n, column, -INFINITY, nextafter(value, -INFINITY), false);
+		case GROUP_LESS_OR_EQUAL:
+			return predicateInitWithRangeDouble
+			(a, n, column, -INFINITY, value, false);
+		case GROUP_EQUAL:
+			return predicateInitWithRangeDouble
+			(a, n, column, value, value, false);
+		case GROUP_NOT_EQUAL:
+			return predicateInitWithRangeDouble
+			(a, n, column, value, value, true);
+		case GROUP_GREATER_OR_EQUAL:
+			return predicateInitWithRangeDouble
+			(a, n, column, value, INFINITY, false);
+		case GROUP_GREATER:
+			return value == INFINITY ?
+			predicateInitWithRangeDouble(a, n, column, 1, 0, false) :
+			predicateInitWithRangeDouble
+			(a, n, column, nextafter(value, INFINITY), INFINITY, false);
 	}
-	if (was) {
-		counter++;
+	
+	macro_err_return_null(true);
+}
+
+group* group_InitWithDoubleRange
+(group* const a, const int n, const double* const column, 
+ const double min, const double max)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && column == NULL);
+	
+	return predicateInitWithRangeDouble(a, n, column, min, max, false);
+}
+
+group* group_InitWithBoolColumn
+(group* const a, const int n, const int* const column)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && column == NULL);
+	
+	return predicateInitWithRangeInt(a, n, column, 0, 0, true);
+}
+
+group* group_InitWithStringEquals
+(group* const a, const int n, const char* const* const column, 
+ const char* const value)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && column == NULL);
+	
+	a->length = 0;
+	a->capacity = 0;
+	a->pointer = NULL;
+	a->readOnly = false;
+	
+	// Strings are compared one by one, but the boundaries are
+	// still taken from the mask a word at a time.
+	unsigned long long words[PREDICATE_CHUNK_WORDS];
+	const char* str;
+	int state = false;
+	int i, j, count;
+	for (i = 0; i < n; i += PREDICATE_CHUNK)
+	{
+		count = n-i < PREDICATE_CHUNK ? n-i : PREDICATE_CHUNK;
+		memset(words, 0, sizeof(words));
+		for (j = 0; j < count; j++)
+		{
+			str = column[i+j];
+			if (str == value || 
+			    (str != NULL && value != NULL && strcmp(str, value) == 0))
+				words[j >> 6] |= 1ULL << (j & 63);
+		}
+		predicateAppend(a, words, count, i, false, &state);
 	}
-	return counter;
+	
+	boundariesFinish(a, n);
+	return a;
 }
 
+//
+// The delta functions compare the columns in one pass. The changed
+// values are marked in a bit mask with vector instructions and the
+// boundaries are taken from it like in the predicate builders.
+//
 group* group_InitWithDeltaDouble
 (group* const a, const int n, const double* const oldValues, 
  const double* const newValues)
@@ -330,29 +557,21 @@ group* group_InitWithDeltaDouble
 	macro_err_return_null(oldValues == NULL); 
 	macro_err_return_null(newValues == NULL);
 	
+	a->length = 0;
 	a->pointer = NULL;
-	
-	if (n == 0) {
-		a->length = 0;
-		return a;
+	a->capacity = 0;
+	a->readOnly = false;
+	
+	unsigned long long words[PREDICATE_CHUNK_WORDS];
+	int state = false;
+	int i, count;
+	for (i = 0; i < n; i += PREDICATE_CHUNK) {
+		count = n-i < PREDICATE_CHUNK ? n-i : PREDICATE_CHUNK;
+		simd_DiffMaskDouble(oldValues+i, newValues+i, count, words);
+		predicateAppend(a, words, count, i, false, &state);
 	}
 	
-	const int count = countDeltaDouble(n, oldValues, newValues);
-	a->length = count;
-	a->pointer = malloc(sizeof(count));
-	int was = false;
-	int is;
-	int k = 0;
-	int i;
-	for (i = 0; i < n; i++) {
-		is = newValues[i] != oldValues[i];
-		if (was != is)
-			a->pointer[k++] = i;
-		was = is;
-	}
-	if (was) {
-		a->pointer[k++] = n;
-	}
+	boundariesFinish(a, n);
 	return a;
 }
 
@@ -365,29 +584,21 @@ group* group_InitWithDeltaInt
 	macro_err_return_null(oldValues == NULL); 
 	macro_err_return_null(newValues == NULL);
 	
+	a->length = 0;
 	a->pointer = NULL;
-	
-	if (n == 0) {
-		a->length = 0;
-		return a;
+	a->capacity = 0;
+	a->readOnly = false;
+	
+	unsigned long long words[PREDICATE_CHUNK_WORDS];
+	int state = false;
+	int i, count;
+	for (i = 0; i < n; i += PREDICATE_CHUNK) {
+		count = n-i < PREDICATE_CHUNK ? n-i : PREDICATE_CHUNK;
+		simd_DiffMaskInt(oldValues+i, newValues+i, count, words);
+		predicateAppend(a, words, count, i, false, &state);
 	}
 	
-	const int count = countDeltaInt(n, oldValues, newValues);
-	a->length = count;
-	a->pointer = malloc(sizeof(count));
-	int was = false;
-	int is;
-	int k = 0;
-	int i;
-	for (i = 0; i < n; i++) {
-		is = newValues[i] != oldValues[i];
-		if (was != is)
-			a->pointer[k++] = i;
-		was = is;
-	}
-	if (was) {
-		a->pointer[k++] = n;
-	}
+	boundariesFinish(a, n);
 	return a;
 }
 
@@ -395,35 +606,7 @@ group* group_InitWithDeltaBool
 (group* const a, const int n, const int* const oldValues, 
  const int* const newValues)
 {
-	macro_err_return_null(a == NULL);
-	macro_err_return_null(n < 0);
-	macro_err_return_null(oldValues == NULL); 
-	macro_err_return_null(newValues == NULL);
-	
-	a->pointer = NULL;
-	
-	if (n == 0) {
-		a->length = 0;
-		return a;
-	}
-	
-	int count = countDeltaBool(n, oldValues, newValues);
-	a->length = count;
-	a->pointer = malloc(sizeof(count));
-	int was = false;
-	int is;
-	int k = 0;
-	int i;
-	for (i = 0; i < n; i++) {
-		is = newValues[i] != oldValues[i];
-		if (was != is)
-			a->pointer[k++] = i;
-		was = is;
-	}
-	if (was) {
-		a->pointer[k++] = n;
-	}
-	return a;
+	return group_InitWithDeltaInt(a, n, oldValues, newValues);
 }
 
 group* group_InitWithDeltaString
@@ -435,32 +618,86 @@ group* group_InitWithDeltaString
 	macro_err_return_null(oldValues == NULL); 
 	macro_err_return_null(newValues == NULL);
 	
+	a->length = 0;
 	a->pointer = NULL;
-	
-	if (n == 0) {
-		a->length = 0;
-		return a;
+	a->capacity = 0;
+	a->readOnly = false;
+	
+	// Strings are compared one by one, but the same pointer is
+	// known to be equal without reading the string.
+	unsigned long long words[PREDICATE_CHUNK_WORDS];
+	int state = false;
+	int i, j, count;
+	for (i = 0; i < n; i += PREDICATE_CHUNK) {
+		count = n-i < PREDICATE_CHUNK ? n-i : PREDICATE_CHUNK;
+		memset(words, 0, sizeof(words));
+		for (j = 0; j < count; j++) {
+			if (newValues[i+j] != oldValues[i+j] &&
+			    strcmp(newValues[i+j], oldValues[i+j]) != 0)
+				words[j >> 6] |= 1ULL << (j & 63);
+		}
+		predicateAppend(a, words, count, i, false, &state);
 	}
 	
-	const int count = countDeltaString(n, oldValues, newValues);
-	a->length = count;
-	a->pointer = malloc(sizeof(count));
-	int was = false;
-	int is;
-	int k = 0;
-	int i;
-	for (i = 0; i < n; i++) {
-		is = strcmp(newValues[i], oldValues[i]) != 0;
-		if (was != is)
-			a->pointer[k++] = i;
-		was = is;
-	}
-	if (was) {
-		a->pointer[k++] = n;
-	}
+	boundariesFinish(a, n);
 	return a;
 }
 
+void textClassTables
+(const unsigned char* const classes, const int bit, 
+ unsigned char* const lo, unsigned char* const hi);
+
+//
+// Describes the bytes of a class by the low and high half of each
+// byte, for 'simd_ByteMask'. The high half selects a bit, so this
+// only works for bytes below 128, which have 8 possible high halves.
+//
+void textClassTables
+(const unsigned char* const classes, const int bit, 
+ unsigned char* const lo, unsigned char* const hi)
+{
+	int ch;
+	memset(lo, 0, 16);
+	memset(hi, 0, 16);
+	for (ch = 0; ch < 128; ch++)
+	{
+		hi[ch >> 4] = 1 << (ch >> 4);
+		if (classes[ch] & bit)
+			lo[ch & 15] |= 1 << (ch >> 4);
+	}
+}
+
+void textClassMask
+(const unsigned char* const classes, const int bit,
+ const unsigned char* const p, const int n, unsigned long long* const mask);
+
+void textClassMask
+(const unsigned char* const classes, const int bit,
+ const unsigned char* const p, const int n, unsigned long long* const mask)
+{
+	int i;
+	for (i = 0; i < (n+63)/64; i++)
+		mask[i] = 0;
+	for (i = 0; i < n; i++)
+		mask[i >> 6] |= (unsigned long long)((classes[p[i]] & bit) != 0) 
+		<< (i & 63);
+}
+
+/*
+	Classes of characters in text.
+	A split character is also a space character.
+*/
+#define TEXT_SPACE 1
+#define TEXT_SPLIT 2
+
+//
+// Builds a table with the class of every byte once and classifies
+// the text in chunks with vector instructions. A boundary is at
+// every split character and where the text goes between space and
+// not space, which is found with bit operations on the masks.
+// If a space or split character is not ASCII, the table is used
+// directly for each byte.
+//
 group* group_InitWithWordsInString
 (group* const a, const char* const text, const char* const spaceCharacters, 
  const char* const splitCharacters)
@@ -470,39 +707,82 @@ group* group_InitWithWordsInString
 	macro_err_return_null(spaceCharacters == NULL); 
 	macro_err_return_null(splitCharacters == NULL);
 	
-	// Loop through and find all sections that does not contain splitting characters.
-	gcstack* const words = gcstack_Init(gcstack_Alloc());
-	int k = 0;
-	int wasSpace = true;
-	int isSpace = false;
-	int isSplit = false;
-	char* spaceCh = NULL;
-	char* splitCh = NULL;
-	char ch;
-	for (ch = text[0]; ch != '\0'; ch = text[++k])
+	const size_t length = strlen(text);
+	macro_err_return_null(length > INT_MAX);
+	const int n = (int)length;
+	
+	unsigned char classes[256];
+	memset(classes, 0, sizeof(classes));
+	const unsigned char* ch;
+	int ascii = true;
+	for (ch = (const unsigned char*)spaceCharacters; *ch != '\0'; ch++)
 	{
-		spaceCh = strchr(spaceCharacters, ch);
-		splitCh = strchr(splitCharacters, ch);
-		isSplit = splitCh != NULL;
-		isSpace = spaceCh != NULL || isSplit;
-		
-		// Split characters are marked whether they follow another or not.
-		if (isSplit) gcstack_PushInt(words, k);
-		else if (!isSpace && wasSpace) gcstack_PushInt(words, k);
-		else if (isSpace && !wasSpace) gcstack_PushInt(words, k);
-		wasSpace = isSpace;
+		classes[*ch] |= TEXT_SPACE;
+		ascii = ascii && *ch < 128;
+	}
+	for (ch = (const unsigned char*)splitCharacters; *ch != '\0'; ch++)
+	{
+		classes[*ch] |= TEXT_SPACE | TEXT_SPLIT;
+		ascii = ascii && *ch < 128;
 	}
 	
-	// If there is no split character at the end, we have to use end of text.
-	if ((words->length % 2) != 0)
-		gcstack_PushInt(words, k);
+	unsigned char spaceLo[16], spaceHi[16], splitLo[16], splitHi[16];
+	textClassTables(classes, TEXT_SPACE, spaceLo, spaceHi);
+	textClassTables(classes, TEXT_SPLIT, splitLo, splitHi);
 	
-	int* const arr = gcstack_CreateIntArrayBackward(words);
-	group_InitWithValues(a, words->length, arr);
-	free(arr);
-	gcstack_Delete(words);
-	free(words);
+	a->length = 0;
+	a->capacity = 0;
+	a->pointer = NULL;
+	a->readOnly = false;
+	
+	const unsigned char* const bytes = (const unsigned char*)text;
+	unsigned long long spaces[PREDICATE_CHUNK_WORDS];
+	unsigned long long splits[PREDICATE_CHUNK_WORDS];
+	unsigned long long w, changes;
+	
+	// The text starts as if there was a space before it.
+	unsigned long long wasSpace = 1;
+	int i, j, count;
+	for (i = 0; i < n; i += PREDICATE_CHUNK)
+	{
+		count = n-i < PREDICATE_CHUNK ? n-i : PREDICATE_CHUNK;
+		if (ascii)
+		{
+			simd_ByteMask(bytes+i, count, spaceLo, spaceHi, spaces);
+			simd_ByteMask(bytes+i, count, splitLo, splitHi, splits);
+		}
+		else
+		{
+			textClassMask(classes, TEXT_SPACE, bytes+i, count, spaces);
+			textClassMask(classes, TEXT_SPLIT, bytes+i, count, splits);
+		}
+		
+		for (j = 0; j < (count+63)/64; j++)
+		{
+			// Split characters are marked whether they follow another
+			// or not.
+			w = spaces[j];
+			changes = splits[j] | (w ^ ((w << 1) | wasSpace));
+			wasSpace = w >> 63;
+			
+			// The bits after the end of the text are not characters.
+			if (count - 64*j < 64)
+				changes &= ~0ULL >> (64 - (count - 64*j));
+			if (changes == 0)
+				continue;
+			
+			boundariesReserve(a, __builtin_popcountll(changes));
+			while (changes != 0)
+			{
+				a->pointer[a->length++] = i + (j << 6) + 
+				__builtin_ctzll(changes);
+				changes &= changes - 1;
+			}
+		}
+	}
 	
+	// If there is no split character at the end, we have to use end of text.
+	boundariesFinish(a, n);
 	return a;
 }
 
@@ -530,6 +810,7 @@ group* group_GcDirectJoin
 	(gc, sizeof(group), group_Delete);
 	
 	arr->length = a->length + b->length;
+	arr->capacity = arr->length;
 	arr->pointer = malloc(sizeof(int)*arr->length);
 	
 	memcpy((void*)arr->pointer, (void*)a->pointer, a->length*sizeof(int));
@@ -546,6 +827,7 @@ group* group_GcClone(gcstack* const gc, const group* const a) {
 	(gc, sizeof(group), group_Delete);
 	
 	b->length = a->length;
+	b->capacity = a->length;
 	b->pointer = malloc(sizeof(int)*b->length);
 	
 	memcpy((void*)b->pointer, (void*)a->pointer, a->length*sizeof(int));
@@ -553,284 +835,315 @@ group* group_GcClone(gcstack* const gc, const group* const a) {
 	return b;
 }
 
-int countAnd(const group* const a, const group* const b);
+/*
+	When one bitstream got this many times more boundaries than the 
+	other, the rows in the larger one are found with galloping search.
+*/
+#define GALLOP_RATIO 32
+
+int gallopCountLess(const int* const p, const int n, const int bound);
 
-int countAnd(const group* const a, const group* const b)
+//
+// Returns the number of values at the beginning of a sorted array that
+// are less than 'bound', like simd_CountLess. It doubles the step
+// until passing the bound and then does a binary search, so the cost
+// grows with the logarithm of the answer instead of the answer.
+//
+int gallopCountLess(const int* const p, const int n, const int bound)
 {
-	int list = 0;
-	
-	if (a->length == 0 || b->length == 0)
-		return list;
+	int lo = 0;
+	int hi = n < 1 ? n : 1;
+	while (hi < n && p[hi-1] < bound)
+	{
+		lo = hi;
+		hi = hi*2 < n ? hi*2 : n;
+	}
 	
-	int i = 0, j = 0;
-	int ba = false;
-	int bb = false;
-	int oldB = false;
-	int pa, pb;
-	while (i < a->length || j < b->length)
+	// The answer is in the range [lo, hi].
+	int mid;
+	while (lo < hi)
+	{
+		mid = lo + (hi-lo)/2;
+		if (p[mid] < bound)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+int mergeBoundaries
+(const int* const A, const int al, const int startA,
+ const int* const B, const int bl, const int startB,
+ const int table, int* const out);
+
+//
+// Walks through both bitstreams once and writes the result to 'out'.
+// The output never contains more than al+bl numbers.
+// Returns the number of written numbers.
+//
+// Fragmented bitstreams often have many boundaries in a row in one
+// bitstream before the next boundary in the other. While the state of
+// the other bitstream stays the same, each of these boundaries either
+// changes the result or none of them do. The length of the row is
+// found with a vectorized search and it is copied or skipped as a whole.
+// If one bitstream is much larger than the other, its rows are found
+// with galloping search, so skipping them costs O(log n).
+//
+// 'startA' and 'startB' are the states before the first boundaries.
+// Rows from A are moved with memmove, because the in-place operators
+// read A from the same buffer as they write to, but always behind.
+//
+int mergeBoundaries
+(const int* const A, const int al, const int startA,
+ const int* const B, const int bl, const int startB,
+ const int table, int* const out)
+{
+	// Whether a boundary in one bitstream changes the result,
+	// indexed by the state of the other bitstream.
+	const int changesA[2] = {
+		macro_merge_value(table, 0, 0) != macro_merge_value(table, 1, 0),
+		macro_merge_value(table, 0, 1) != macro_merge_value(table, 1, 1)
+	};
+	const int changesB[2] = {
+		macro_merge_value(table, 0, 0) != macro_merge_value(table, 0, 1),
+		macro_merge_value(table, 1, 0) != macro_merge_value(table, 1, 1)
+	};
+	
+	const int gallopA = al/GALLOP_RATIO > bl;
+	const int gallopB = bl/GALLOP_RATIO > al;
+	
+	int i = 0, j = 0, k = 0;
+	int ba = startA;
+	int bb = startB;
+	int pa, pb, n;
+	while (i < al && j < bl)
 	{
-		pa = a->pointer[i>=a->length?a->length-1:i];
-		pb = b->pointer[j>=b->length?b->length-1:j];
+		pa = A[i];
+		pb = B[j];
 		
-		if (pa == pb)
+		if (pa < pb)
 		{
-			ba = !ba;
-			bb = !bb;
-			if ((ba && bb) != oldB)
-				list++;
-			i++;
-			j++;
+			n = 1;
+			if (i+1 < al && A[i+1] < pb)
+				n += gallopA ?
+				gallopCountLess(A+i+1, al-i-1, pb) :
+				simd_CountLess(A+i+1, al-i-1, pb);
+			if (changesA[bb])
+			{
+				memmove(out+k, A+i, n*sizeof(int));
+				k += n;
+			}
+			ba ^= n & 1;
+			i += n;
 		}
-		else if ((pa < pb || j >= b->length) && i < a->length)
+		else if (pb < pa)
 		{
-			ba = !ba;
-			if ((ba && bb) != oldB)
-				list++;
-			i++;
+			n = 1;
+			if (j+1 < bl && B[j+1] < pa)
+				n += gallopB ?
+				gallopCountLess(B+j+1, bl-j-1, pa) :
+				simd_CountLess(B+j+1, bl-j-1, pa);
+			if (changesB[ba])
+			{
+				memcpy(out+k, B+j, n*sizeof(int));
+				k += n;
+			}
+			bb ^= n & 1;
+			j += n;
 		}
-		else if (j < b->length)
+		else
 		{
+			// Both flags toggle when the boundaries are equal.
+			out[k] = pa;
+			k += macro_merge_value(table, ba, bb) != 
+			macro_merge_value(table, !ba, !bb);
+			ba = !ba;
 			bb = !bb;
-			if ((ba && bb) != oldB)
-				list++;
+			i++;
 			j++;
 		}
-		else
-			break;
-		
-		oldB = ba && bb;
 	}
 	
-	return list;
+	// When one bitstream is used up, the state of it no longer changes.
+	if (i < al && changesA[bb])
+	{
+		memmove(out+k, A+i, (al-i)*sizeof(int));
+		k += al-i;
+	}
+	if (j < bl && changesB[ba])
+	{
+		memcpy(out+k, B+j, (bl-j)*sizeof(int));
+		k += bl-j;
+	}
+	
+	return k;
 }
 
+int rowSize(const int* const p, const int n, int* const on, int* const from);
 
-group* group_GcAnd
-(gcstack* const gc, const group* const a, const group* const b)
+//
+// Adds up the blocks formed by a row of boundaries that all change
+// the result. 'on' is the state of the result before the row and
+// 'from' is where the current block started.
+//
+int rowSize(const int* const p, const int n, int* const on, int* const from)
 {
-	macro_err_return_null(a == NULL);
-	macro_err_return_null(b == NULL);
-	
-	int list = 0;
-	group* const arr = group_InitWithSize
-	(group_GcAlloc(gc), countAnd(a, b));
+	int size = 0;
+	int i = 0;
+	if (*on && n > 0)
+	{
+		size += p[0] - *from;
+		i = 1;
+	}
+	for (; i+1 < n; i += 2)
+		size += p[i+1] - p[i];
 	
-	if (a->length == 0 || b->length == 0)
-		return arr;
+	if (i < n)
+		*from = p[i];
+	*on ^= n & 1;
+	return size;
+}
+
+int mergeSize
+(const int* const A, const int al, const int* const B, const int bl,
+ const int table);
+
+//
+// Computes the size of the result of a merge without writing it.
+// The walk is the same as in 'mergeBoundaries', but the rows that
+// change the result are added up instead of copied.
+// Returns -1 if the result is infinite.
+//
+int mergeSize
+(const int* const A, const int al, const int* const B, const int bl,
+ const int table)
+{
+	const int changesA[2] = {
+		macro_merge_value(table, 0, 0) != macro_merge_value(table, 1, 0),
+		macro_merge_value(table, 0, 1) != macro_merge_value(table, 1, 1)
+	};
+	const int changesB[2] = {
+		macro_merge_value(table, 0, 0) != macro_merge_value(table, 0, 1),
+		macro_merge_value(table, 1, 0) != macro_merge_value(table, 1, 1)
+	};
+	
+	const int gallopA = al/GALLOP_RATIO > bl;
+	const int gallopB = bl/GALLOP_RATIO > al;
 	
 	int i = 0, j = 0;
 	int ba = false;
 	int bb = false;
-	int oldB = false;
-	int pa, pb;
-	while (i < a->length || j < b->length)
+	int on = macro_merge_value(table, 0, 0);
+	int from = 0;
+	int size = 0;
+	int pa, pb, n;
+	while (i < al && j < bl)
 	{
-		pa = a->pointer[i>=a->length?a->length-1:i];
-		pb = b->pointer[j>=b->length?b->length-1:j];
+		pa = A[i];
+		pb = B[j];
 		
-		if (pa == pb)
+		if (pa < pb)
+		{
+			n = 1;
+			if (i+1 < al && A[i+1] < pb)
+				n += gallopA ?
+				gallopCountLess(A+i+1, al-i-1, pb) :
+				simd_CountLess(A+i+1, al-i-1, pb);
+			if (changesA[bb])
+				size += rowSize(A+i, n, &on, &from);
+			ba ^= n & 1;
+			i += n;
+		}
+		else if (pb < pa)
+		{
+			n = 1;
+			if (j+1 < bl && B[j+1] < pa)
+				n += gallopB ?
+				gallopCountLess(B+j+1, bl-j-1, pa) :
+				simd_CountLess(B+j+1, bl-j-1, pa);
+			if (changesB[ba])
+				size += rowSize(B+j, n, &on, &from);
+			bb ^= n & 1;
+			j += n;
+		}
+		else
 		{
+			if (macro_merge_value(table, ba, bb) != 
+			    macro_merge_value(table, !ba, !bb))
+				size += rowSize(A+i, 1, &on, &from);
 			ba = !ba;
 			bb = !bb;
-			if ((ba && bb) != oldB)
-			{
-				arr->pointer[list++] = pa;
-			}
 			i++;
 			j++;
 		}
-		else if ((pa < pb || j >= b->length) && i < a->length)
-		{
-			ba = !ba;
-			if ((ba && bb) != oldB)
-				arr->pointer[list++] = pa;
-			i++;
-		}
-		else if (j < b->length)
-		{
-			bb = !bb;
-			if ((ba && bb) != oldB)
-				arr->pointer[list++] = pb;
-			j++;
-		}
-		else
-			break;
-		
-		oldB = ba && bb;
 	}
 	
-	return arr;
+	if (i < al && changesA[bb])
+		size += rowSize(A+i, al-i, &on, &from);
+	if (j < bl && changesB[ba])
+		size += rowSize(B+j, bl-j, &on, &from);
+	
+	return on ? -1 : size;
 }
 
-int countOr(const group* const a, const group* const b);
+void mergeTo
+(const group* const a, const group* const b, const int table, 
+ group* const res);
 
-int countOr(const group* const a, const group* const b)
+//
+// Allocates room for the worst case and shrinks the buffer afterwards.
+// This replaces the old simulation pass that counted the result first.
+//
+void mergeTo
+(const group* const a, const group* const b, const int table, 
+ group* const res)
 {
-	// var list = [];
-	int counter = 0;
+	const int size = a->length + b->length;
 	
-	if (a->length == 0 && b->length == 0)
-		// return list;
-		return counter;
-	if (a->length == 0)
-	{
-		return b->length;
-	}
-	if (b->length == 0)
-	{
-		return a->length;
-	}
+	res->length = 0;
+	res->capacity = 0;
+	res->pointer = NULL;
+	res->readOnly = false;
+	if (size == 0)
+		return;
 	
-	int i = 0, j = 0;
-	int ba = false;
-	int bb = false;
-	int oldB = false;
-	while (i < a->length || j < b->length)
+	int* const buff = malloc(sizeof(int)*size);
+	const int length = mergeBoundaries
+	(a->pointer, a->length, false, b->pointer, b->length, false, 
+	 table, buff);
+	
+	if (length == 0)
 	{
-		int pa = a->pointer[i>=a->length?a->length-1:i];
-		int pb = b->pointer[j>=b->length?b->length-1:j];
-		
-		if (pa == pb)
-		{
-			ba = !ba;
-			bb = !bb;
-			if ((ba || bb) != oldB)
-				// list.push(pa);
-				counter++;
-			i++;
-			j++;
-		}
-		else if ((pa < pb || j >= b->length) && i < a->length)
-		{
-			ba = !ba;
-			if ((ba || bb) != oldB)
-				// list.push(pa);
-				counter++;
-			i++;
-		}
-		else if (j < b->length)
-		{
-			bb = !bb;
-			if ((ba || bb) != oldB)
-				// list.push(pb);
-				counter++;
-			j++;
-		}
-		else
-			break;
-		
-		oldB = ba || bb;
+		free(buff);
+		return;
 	}
 	
-	// return list;
-	return counter;
+	res->length = length;
+	res->capacity = length;
+	res->pointer = length == size ? buff : 
+	realloc(buff, sizeof(int)*length);
 }
 
-
-group* group_GcOr(gcstack* gc, group const* a, group const* b)
+group* group_GcAnd
+(gcstack* const gc, const group* const a, const group* const b)
 {
 	macro_err_return_null(a == NULL);
 	macro_err_return_null(b == NULL);
 	
-	int count = countOr(a,b);
-	
-	group* const list = group_InitWithSize
-	(group_GcAlloc(gc), count);
-	
-	int counter = 0;
-	const int a_length = a->length;
-	const int b_length = b->length;
-	int* const list_pointer = list->pointer;
-	
-	if (a_length == 0 && b_length == 0)
-		return list;
-	
-	int k;
-	if (a_length == 0)
-	{
-		for (k = 0; k < b_length; k++)
-			list_pointer[counter++] = b->pointer[k];
-		return list;
-	}
-	if (b_length == 0)
-	{
-		for (k = 0; k < a_length; k++)
-			list_pointer[counter++] = a->pointer[k];
-		return list;
-	}
-	
-	int i = 0, j = 0;
-	int ba = false;
-	int bb = false;
-	int oldB = false;
-	while (i < a_length || j < b_length)
-	{
-		int pa = a->pointer[i>=a_length?a_length-1:i];
-		int pb = b->pointer[j>=b_length?b_length-1:j];
-		
-		if (pa == pb)
-		{
-			ba = !ba;
-			bb = !bb;
-			if ((ba || bb) != oldB)
-				list_pointer[counter++] = pa;
-			i++;
-			j++;
-		}
-		else if ((pa < pb || j >= b_length) && i < a_length)
-		{
-			ba = !ba;
-			if ((ba || bb) != oldB)
-				list_pointer[counter++] = pa;
-			i++;
-		}
-		else if (j < b_length)
-		{
-			bb = !bb;
-			if ((ba || bb) != oldB)
-				list_pointer[counter++] = pb;
-			j++;
-		}
-		else
-			break;
-		
-		oldB = ba || bb;
-	}
-	
-	return list;
+	group* const arr = group_GcAlloc(gc);
+	mergeTo(a, b, MERGE_AND, arr);
+	return arr;
 }
 
-int countInvert(group* const a, const int inv);
-
-int countInvert(group* const a, const int inv)
+group* group_GcOr(gcstack* gc, group const* a, group const* b)
 {
-	// var res = [];
-	int resCount = 0;
-	
-	int added = false;
-	int i;
-	for (i = 0; i < a->length; i++)
-	{
-		if (a->pointer[i] == inv)
-		{
-			added = true;
-			continue;
-		}
-		if (a->pointer[i] > inv && !added)
-		{
-			// res.push(inv);
-			resCount++;
-			added = true;
-		}
-		// res.push(a[i]);
-		resCount++;
-	}
-	if (!added)
-		// res.push(inv);
-		resCount++;
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
 	
-	// return res;
-	return resCount;
+	group* const list = group_GcAlloc(gc);
+	mergeTo(a, b, MERGE_OR, list);
+	return list;
 }
 
 group* group_GcInvert
@@ -838,8 +1151,9 @@ group* group_GcInvert
 {
 	macro_err_return_null(a == NULL);
 	
+	// The result has one number more or one less than the input.
 	group* const res = group_InitWithSize
-	(group_GcAlloc(gc), countInvert(a, inv));
+	(group_GcAlloc(gc), a->length+1);
 	
 	int resCount = 0;
 	
@@ -860,216 +1174,889 @@ group* group_GcInvert
 		res->pointer[resCount++] = a->pointer[i];
 	}
 	if (!added)
+		res->pointer[resCount++] = inv;
+	
+	res->length = resCount;
+	if (resCount == 0)
 	{
-		res->pointer[resCount] = inv;
+		free(res->pointer);
+		res->pointer = NULL;
+		res->capacity = 0;
 	}
 	
 	return res;
 }
 
-int countExcept(const group* const a, const group* const b);
+void group_ExceptTmp
+(const group* const a, const group* const b, group* const tmp)
+{
+	macro_err_return(a == NULL);
+	macro_err_return(b == NULL);
+	
+	mergeTo(a, b, MERGE_EXCEPT, tmp);
+}
 
-int countExcept(const group* const a, const group* const b)
+group* group_GcExcept
+(gcstack* const gc, const group* const a, const group* const b)
 {
-	int list = 0;
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
 	
-	const int a_length = a->length;
-	const int b_length = b->length;
+	group* const arr = group_GcAlloc(gc);
+	mergeTo(a, b, MERGE_EXCEPT, arr);
+	return arr;
+}
+
+/*
+	Each thread gets at least this many boundaries, because starting
+	a thread costs more than merging a smaller partition.
+*/
+#define PARALLEL_MIN_BOUNDARIES 65536
+#define PARALLEL_MAX_THREADS 256
+
+typedef struct mergePartition {
+	const int* A;
+	int al;
+	int startA;
+	const int* B;
+	int bl;
+	int startB;
+	int table;
+	int* out;
+	int length;
+} mergePartition;
+
+void* mergePartitionRun(void* const p);
+
+void* mergePartitionRun(void* const p)
+{
+	mergePartition* const part = (mergePartition*)p;
+	part->length = mergeBoundaries
+	(part->A, part->al, part->startA, part->B, part->bl, part->startB,
+	 part->table, part->out);
+	return NULL;
+}
+
+void mergeSplit
+(const int* const A, const int al, const int* const B, const int bl,
+ const int k, int* const ia, int* const ib);
+
+//
+// Finds where to split both bitstreams so that about 'k' boundaries
+// come before the split. The position in A is found with binary
+// search such that the first 'k' boundaries of the merged order are
+// on the left. The split is then moved to the next boundary value,
+// so equal boundaries in A and B end up in the same partition.
+//
+void mergeSplit
+(const int* const A, const int al, const int* const B, const int bl,
+ const int k, int* const ia, int* const ib)
+{
+	int lo = k > bl ? k-bl : 0;
+	int hi = k < al ? k : al;
+	int mid;
+	while (lo < hi)
+	{
+		mid = lo + (hi-lo)/2;
+		if (A[mid] < B[k-mid-1])
+			lo = mid+1;
+		else
+			hi = mid;
+	}
 	
-	if (a_length == 0 || b_length == 0)
-		return list;
+	const int i = lo;
+	const int j = k-lo;
+	if (i >= al && j >= bl)
+	{
+		*ia = al;
+		*ib = bl;
+		return;
+	}
 	
-	int i = 0, j = 0;
-	int ba = false;
-	int bb = true;
-	int oldB = false;
-	int pa;
-	int pb;
+	const int v = j >= bl || (i < al && A[i] <= B[j]) ? A[i] : B[j];
+	*ia = gallopCountLess(A, al, v);
+	*ib = gallopCountLess(B, bl, v);
+}
+
+void mergeParallelTo
+(const group* const a, const group* const b, const int table, 
+ const int threads, group* const res);
+
+//
+// Splits the bitstreams at the same values and merges each part on a
+// thread of its own. The state of a bitstream before a split is the
+// parity of the boundaries on the left, so every part starts in the
+// right state. Since each part only writes the boundaries where the
+// result changes, the parts are stitched together by concatenating
+// them. A block crossing a split starts in one part and ends in the
+// next, so it needs no special care.
+//
+void mergeParallelTo
+(const group* const a, const group* const b, const int table, 
+ const int threads, group* const res)
+{
+	const int size = a->length + b->length;
+	int n = threads > 0 ? threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (n > size / PARALLEL_MIN_BOUNDARIES)
+		n = size / PARALLEL_MIN_BOUNDARIES;
+	if (n > PARALLEL_MAX_THREADS)
+		n = PARALLEL_MAX_THREADS;
+	if (n < 2)
+	{
+		mergeTo(a, b, table, res);
+		return;
+	}
 	
-	while (i < a_length || j < b_length)
+	mergePartition parts[PARALLEL_MAX_THREADS];
+	pthread_t ids[PARALLEL_MAX_THREADS];
+	int* const buff = malloc(sizeof(int)*size);
+	int ia = 0, ib = 0, nextA, nextB;
+	int i;
+	for (i = 0; i < n; i++)
 	{
-		pa = a->pointer[i>=a_length?a_length-1:i];
-		pb = b->pointer[j>=b_length?b_length-1:j];
-		
-		if (pa == pb)
-		{
-			ba = !ba;
-			bb = !bb;
-			if ((ba && bb) != oldB)
-				list++;
-			i++;
-			j++;
-		}
-		else if ((pa < pb || j >= b_length) && i < a_length)
-		{
-			ba = !ba;
-			if ((ba && bb) != oldB)
-				list++;
-			i++;
-		}
-		else if (j < b_length)
+		if (i == n-1)
 		{
-			bb = !bb;
-			if ((ba && bb) != oldB)
-				list++;
-			j++;
+			nextA = a->length;
+			nextB = b->length;
 		}
 		else
-			break;
+			mergeSplit(a->pointer, a->length, b->pointer, b->length,
+					   (int)((long long)size*(i+1)/n), &nextA, &nextB);
 		
-		oldB = ba && bb;
+		parts[i].A = a->pointer + ia;
+		parts[i].al = nextA - ia;
+		parts[i].startA = ia & 1;
+		parts[i].B = b->pointer + ib;
+		parts[i].bl = nextB - ib;
+		parts[i].startB = ib & 1;
+		parts[i].table = table;
+		parts[i].out = buff + ia + ib;
+		parts[i].length = 0;
+		ia = nextA;
+		ib = nextB;
 	}
 	
-	return list;
+	// The first part runs on this thread.
+	// If a thread can not be started, the part runs here too.
+	int started[PARALLEL_MAX_THREADS];
+	for (i = 1; i < n; i++)
+		started[i] = pthread_create(&ids[i], NULL, mergePartitionRun, 
+									&parts[i]) == 0;
+	mergePartitionRun(&parts[0]);
+	
+	int length = parts[0].length;
+	for (i = 1; i < n; i++)
+	{
+		if (started[i])
+			pthread_join(ids[i], NULL);
+		else
+			mergePartitionRun(&parts[i]);
+		
+		memmove(buff + length, parts[i].out, sizeof(int)*parts[i].length);
+		length += parts[i].length;
+	}
+	
+	res->length = length;
+	res->capacity = length;
+	res->readOnly = false;
+	if (length == 0)
+	{
+		free(buff);
+		res->capacity = 0;
+		res->pointer = NULL;
+		return;
+	}
+	
+	res->pointer = length == size ? buff : 
+	realloc(buff, sizeof(int)*length);
 }
 
-void group_ExceptTmp
-(const group* const a, const group* const b, group* const tmp)
+group* group_GcParallelAnd
+(gcstack* const gc, const group* const a, const group* const b, 
+ const int threads)
 {
-	macro_err_return(a == NULL);
-	macro_err_return(b == NULL);
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+	
+	group* const arr = group_GcAlloc(gc);
+	mergeParallelTo(a, b, MERGE_AND, threads, arr);
+	return arr;
+}
+
+group* group_GcParallelOr
+(gcstack* const gc, const group* const a, const group* const b, 
+ const int threads)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+	
+	group* const arr = group_GcAlloc(gc);
+	mergeParallelTo(a, b, MERGE_OR, threads, arr);
+	return arr;
+}
+
+group* group_GcParallelExcept
+(gcstack* const gc, const group* const a, const group* const b, 
+ const int threads)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
 	
-	const int a_length = a->length;
-	const int b_length = b->length;
-	if (b_length == 0) {
-		tmp->length = a_length;
-		tmp->pointer = malloc(sizeof(int)*a_length);
-		memcpy(tmp->pointer, a->pointer, sizeof(int)*a_length);
+	group* const arr = group_GcAlloc(gc);
+	mergeParallelTo(a, b, MERGE_EXCEPT, threads, arr);
+	return arr;
+}
+
+
+void rangeBounds
+(const group* const a, const int start, const int end, 
+ int* const from, int* const to);
+
+//
+// Finds the boundaries of a bitstream that are inside ('start', 'end').
+// The boundaries before 'from' are less than or equal to 'start', so
+// the state at 'start' is the parity of 'from', and likewise the state
+// right before 'end' is the parity of 'to'.
+//
+void rangeBounds
+(const group* const a, const int start, const int end, 
+ int* const from, int* const to)
+{
+	*from = gallopCountLess(a->pointer, a->length, start+1);
+	*to = *from + 
+	gallopCountLess(a->pointer+*from, a->length-*from, end);
+}
+
+void mergeRangeTo
+(const group* const a, const group* const b, const int table, 
+ const int start, const int end, group* const res);
+
+//
+// Merges the parts of two bitstreams that are inside [start, end).
+// Both bitstreams are cut by binary search and the states at 'start'
+// are passed to the merge, so only the window is walked through.
+//
+void mergeRangeTo
+(const group* const a, const group* const b, const int table, 
+ const int start, const int end, group* const res)
+{
+	res->length = 0;
+	res->capacity = 0;
+	res->pointer = NULL;
+	res->readOnly = false;
+	if (start >= end)
+		return;
+	
+	int fromA, toA, fromB, toB;
+	rangeBounds(a, start, end, &fromA, &toA);
+	rangeBounds(b, start, end, &fromB, &toB);
+	
+	const int first = macro_merge_value(table, fromA & 1, fromB & 1);
+	const int last = macro_merge_value(table, toA & 1, toB & 1);
+	
+	// Room for the window plus the start and end of the range.
+	const int size = toA-fromA + toB-fromB + 2;
+	int* const buff = malloc(sizeof(int)*size);
+	int length = 0;
+	if (first)
+		buff[length++] = start;
+	length += mergeBoundaries
+	(a->pointer+fromA, toA-fromA, fromA & 1, 
+	 b->pointer+fromB, toB-fromB, fromB & 1, table, buff+length);
+	if (last)
+		buff[length++] = end;
+	
+	if (length == 0)
+	{
+		free(buff);
 		return;
 	}
 	
-	int list = 0;
+	res->length = length;
+	res->capacity = length;
+	res->pointer = length == size ? buff : 
+	realloc(buff, sizeof(int)*length);
+}
+
+group* group_GcSlice
+(gcstack* const gc, const group* const a, const int start, const int end)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(start > end);
+	
+	group* const res = group_GcAlloc(gc);
+	res->length = 0;
+	res->capacity = 0;
+	res->pointer = NULL;
+	res->readOnly = false;
+	if (start == end)
+		return res;
+	
+	int from, to;
+	rangeBounds(a, start, end, &from, &to);
+	
+	const int first = from & 1;
+	const int length = first + to-from + (to & 1);
+	if (length == 0)
+		return res;
+	
+	int* const buff = malloc(sizeof(int)*length);
+	if (first)
+		buff[0] = start;
+	memcpy(buff+first, a->pointer+from, (to-from)*sizeof(int));
+	if (to & 1)
+		buff[length-1] = end;
+	
+	res->length = length;
+	res->capacity = length;
+	res->pointer = buff;
+	return res;
+}
+
+group* group_GcAndRange
+(gcstack* const gc, const group* const a, const group* const b, 
+ const int start, const int end)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+	macro_err_return_null(start > end);
 	
-	group_InitWithSize(tmp, countExcept(a, b));
+	group* const arr = group_GcAlloc(gc);
+	mergeRangeTo(a, b, MERGE_AND, start, end, arr);
+	return arr;
+}
+
+group* group_GcOrRange
+(gcstack* const gc, const group* const a, const group* const b, 
+ const int start, const int end)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+	macro_err_return_null(start > end);
 	
-	if (a_length == 0 || b_length == 0)
+	group* const arr = group_GcAlloc(gc);
+	mergeRangeTo(a, b, MERGE_OR, start, end, arr);
+	return arr;
+}
+
+group* group_GcExceptRange
+(gcstack* const gc, const group* const a, const group* const b, 
+ const int start, const int end)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+	macro_err_return_null(start > end);
+	
+	group* const arr = group_GcAlloc(gc);
+	mergeRangeTo(a, b, MERGE_EXCEPT, start, end, arr);
+	return arr;
+}
+
+void mergeInPlace(group* const a, const group* const b, const int table);
+
+//
+// Merges 'b' into the buffer of 'a'.
+// The boundaries in 'a' from the first one affected by 'b' are moved
+// toward the end of the buffer, and the result is written from the
+// front while reading behind. The buffer grows geometrically when
+// it is too small, so repeated updates reuse the same memory.
+//
+void mergeInPlace(group* const a, const group* const b, const int table)
+{
+	const int al = a->length;
+	const int bl = b->length;
+	
+	if ((a->pointer == b->pointer && al > 0) || a->readOnly)
+	{
+		// The buffer can not be both input and output, and a read only
+		// view gets its own buffer the first time it is changed.
+		group tmp;
+		mergeTo(a, b, table, &tmp);
+		group_Delete(a);
+		a->length = tmp.length;
+		a->capacity = tmp.capacity;
+		a->pointer = tmp.pointer;
+		a->readOnly = false;
+		return;
+	}
+	if (bl == 0)
+	{
+		if (table == MERGE_AND)
+			a->length = 0;
 		return;
+	}
 	
-	int i = 0, j = 0;
-	int ba = false;
-	int bb = true;
-	int oldB = false;
-	int pa;
-	int pb;
-	while (i < a_length || j < b_length)
+	// Boundaries before the first one in 'b' are outside 'b'.
+	// They are kept as they are by Or and Except, but removed by And.
+	const int lo = gallopCountLess(a->pointer, al, b->pointer[0]);
+	const int start = table == MERGE_AND ? 0 : lo;
+	
+	const int size = al+bl;
+	if (a->capacity < size)
 	{
-		pa = a->pointer[i>=a_length?a_length-1:i];
-		pb = b->pointer[j>=b_length?b_length-1:j];
+		a->capacity = a->capacity*2 > size ? a->capacity*2 : size;
+		a->pointer = realloc(a->pointer, sizeof(int)*a->capacity);
+	}
+	
+	int* const p = a->pointer;
+	memmove(p+lo+bl, p+lo, (al-lo)*sizeof(int));
+	a->length = start + mergeBoundaries
+	(p+lo+bl, al-lo, lo & 1, b->pointer, bl, false, table, p+start);
+}
+
+void group_OrInPlace(group* const a, const group* const b)
+{
+	macro_err_return(a == NULL);
+	macro_err_return(b == NULL);
+	
+	mergeInPlace(a, b, MERGE_OR);
+}
+
+void group_AndInPlace(group* const a, const group* const b)
+{
+	macro_err_return(a == NULL);
+	macro_err_return(b == NULL);
+	
+	mergeInPlace(a, b, MERGE_AND);
+}
+
+void group_ExceptInPlace(group* const a, const group* const b)
+{
+	macro_err_return(a == NULL);
+	macro_err_return(b == NULL);
+	
+	mergeInPlace(a, b, MERGE_EXCEPT);
+}
+
+void sweepHeapDown
+(int* const heap, const int n, int pos, const int* const* const heads);
+
+//
+// Restores the heap order by moving an item down from 'pos'.
+// The heap contains indices of bitstreams sorted by their next boundary.
+//
+void sweepHeapDown
+(int* const heap, const int n, int pos, const int* const* const heads)
+{
+	const int item = heap[pos];
+	const int val = *heads[item];
+	int child;
+	while ((child = pos*2+1) < n)
+	{
+		if (child+1 < n && *heads[heap[child+1]] < *heads[heap[child]])
+			child++;
+		if (val <= *heads[heap[child]])
+			break;
+		heap[pos] = heap[child];
+		pos = child;
+	}
+	heap[pos] = item;
+}
+
+int sweepFunction
+(const int n, const group* const* const groups, 
+ const group_sweep_function f, void* const data, const int threshold, 
+ int* const out);
+
+//
+// Walks through all boundaries of many bitstreams in sorted order.
+// A min-heap picks the bitstream with the next boundary, and the
+// states of the bitstreams are tracked at the current position.
+// If 'f' is NULL, the result is true where at least 'threshold'
+// bitstreams are true. Otherwise 'f' computes the result from the
+// states each time one or more of them change.
+// The output never contains more numbers than all the inputs together.
+// Returns the number of written numbers.
+// If 'out' is NULL, nothing is written and the size of the result is
+// returned instead, or -1 if the result is infinite.
+//
+int sweepFunction
+(const int n, const group* const* const groups, 
+ const group_sweep_function f, void* const data, const int threshold, 
+ int* const out)
+{
+	// One allocation for the heap and the states,
+	// and one for the read positions and the ends.
+	int* const heap = malloc(sizeof(int)*n*2);
+	int* const states = heap+n;
+	const int** const heads = malloc(sizeof(int*)*n*2);
+	const int** const ends = heads+n;
+	
+	int heapSize = 0;
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		states[i] = false;
+		if (groups[i]->length == 0)
+			continue;
+		heads[i] = groups[i]->pointer;
+		ends[i] = groups[i]->pointer + groups[i]->length;
+		heap[heapSize++] = i;
+	}
+	for (i = heapSize/2-1; i >= 0; i--)
+		sweepHeapDown(heap, heapSize, i, heads);
+	
+	// Empty bitstreams can never be true again.
+	int reachable = heapSize;
+	
+	int count = 0;
+	int was = false;
+	int now;
+	int k = 0;
+	int size = 0;
+	int from = 0;
+	int val, item;
+	while (heapSize > 0)
+	{
+		val = *heads[heap[0]];
 		
-		if (pa == pb)
-		{
-			ba = !ba;
-			bb = !bb;
-			if ((ba && bb) != oldB)
+		// Toggle every bitstream that got a boundary at this position.
+		do {
+			item = heap[0];
+			states[item] = !states[item];
+			count += states[item] ? 1 : -1;
+			heads[item]++;
+			
+			if (heads[item] == ends[item])
 			{
-				tmp->pointer[list++] = pa;
+				if ((groups[item]->length & 1) == 0)
+					reachable--;
+				heap[0] = heap[--heapSize];
 			}
-			i++;
-			j++;
-		}
-		else if ((pa < pb || j >= b_length) && i < a_length)
-		{
-			ba = !ba;
-			if ((ba && bb) != oldB)
-				tmp->pointer[list++] = pa;
-			i++;
-		}
-		else if (j < b_length)
+			if (heapSize > 0)
+				sweepHeapDown(heap, heapSize, 0, heads);
+		} while (heapSize > 0 && *heads[heap[0]] == val);
+		
+		now = f == NULL ? count >= threshold : f(n, states, data) != 0;
+		if (now != was)
 		{
-			bb = !bb;
-			if ((ba && bb) != oldB)
-				tmp->pointer[list++] = pb;
-			j++;
+			if (out != NULL)
+				out[k] = val;
+			else if (now)
+				from = val;
+			else
+				size += val - from;
+			k++;
 		}
-		else
-			break;
+		was = now;
 		
-		oldB = ba && bb;
+		// Stop when the counter can not reach the threshold again.
+		if (f == NULL && !was && reachable < threshold)
+			break;
 	}
+	
+	free(heap);
+	free(heads);
+	
+	if (out == NULL)
+		return was ? -1 : size;
+	return k;
 }
 
-group* group_GcExcept
-(gcstack* const gc, const group* const a, const group* const b)
+group* gcSweepFunction
+(gcstack* const gc, const int n, const group* const* const groups, 
+ const group_sweep_function f, void* const data, const int threshold);
+
+group* gcSweepFunction
+(gcstack* const gc, const int n, const group* const* const groups, 
+ const group_sweep_function f, void* const data, const int threshold)
 {
-	macro_err_return_null(a == NULL);
-	macro_err_return_null(b == NULL);
+	group* const res = group_GcAlloc(gc);
+	res->length = 0;
+	res->capacity = 0;
+	res->pointer = NULL;
+	res->readOnly = false;
+	
+	int size = 0;
+	int i;
+	for (i = 0; i < n; i++)
+		size += groups[i]->length;
+	if (size == 0)
+		return res;
+	
+	int* const buff = malloc(sizeof(int)*size);
+	const int length = sweepFunction(n, groups, f, data, threshold, buff);
+	if (length == 0)
+	{
+		free(buff);
+		return res;
+	}
+	
+	res->length = length;
+	res->capacity = length;
+	res->pointer = length == size ? buff : 
+	realloc(buff, sizeof(int)*length);
+	return res;
+}
+
+group* group_GcSweep
+(gcstack* const gc, const int n, const group* const* const groups, 
+ const group_sweep_function f, void* const data)
+{
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && groups == NULL);
+	macro_err_return_null(f == NULL);
 	
-	const int a_length = a->length;
-	const int b_length = b->length;
-	if (b_length == 0)
-		return group_GcClone(gc, a);
+	int i;
+	for (i = 0; i < n; i++) {
+		macro_err_return_null(groups[i] == NULL);
+	}
 	
-	int list = 0;
+	return gcSweepFunction(gc, n, groups, f, data, 0);
+}
+
+group* group_GcOrMany
+(gcstack* const gc, const int n, const group* const* const groups)
+{
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && groups == NULL);
 	
-	group* arr = group_InitWithSize
-	(group_GcAlloc(gc), countExcept(a, b));
+	int i;
+	for (i = 0; i < n; i++) {
+		macro_err_return_null(groups[i] == NULL);
+	}
 	
-	if (a_length == 0 || b_length == 0)
-		return arr;
+	if (n == 2)
+		return group_GcOr(gc, groups[0], groups[1]);
 	
-	int i = 0, j = 0;
-	int ba = false;
-	int bb = true;
-	int oldB = false;
-	int pa;
-	int pb;
-	while (i < a_length || j < b_length)
+	return gcSweepFunction(gc, n, groups, NULL, NULL, 1);
+}
+
+group* group_GcAndMany
+(gcstack* const gc, const int n, const group* const* const groups)
+{
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && groups == NULL);
+	
+	int i;
+	for (i = 0; i < n; i++) {
+		macro_err_return_null(groups[i] == NULL);
+	}
+	
+	if (n == 2)
+		return group_GcAnd(gc, groups[0], groups[1]);
+	
+	// And of no bitstreams is returned as empty.
+	return gcSweepFunction(gc, n, groups, NULL, NULL, n == 0 ? 1 : n);
+}
+
+int truthTableFunction
+(const int n, const int* const states, void* const data);
+
+//
+// Looks up the states in a truth table, with the first bitstream as
+// the highest bit of the index.
+//
+int truthTableFunction
+(const int n, const int* const states, void* const data)
+{
+	const unsigned char* const table = (const unsigned char*)data;
+	unsigned int index = 0;
+	int i;
+	for (i = 0; i < n; i++)
+		index = (index << 1) | states[i];
+	return (table[index >> 3] >> (index & 7)) & 1;
+}
+
+group* group_GcTruthTable
+(gcstack* const gc, const int n, const group* const* const groups, 
+ const unsigned char* const table)
+{
+	macro_err_return_null(n < 1);
+	macro_err_return_null(n > GROUP_TRUTH_TABLE_INPUTS);
+	macro_err_return_null(groups == NULL);
+	macro_err_return_null(table == NULL);
+	
+	// The result must be false where all bitstreams are false,
+	// or it would have no start.
+	macro_err_return_null((table[0] & 1) != 0);
+	
+	int i;
+	for (i = 0; i < n; i++) {
+		macro_err_return_null(groups[i] == NULL);
+	}
+	
+	// Two bitstreams use the same table as the pairwise merge.
+	if (n == 2)
 	{
-		pa = a->pointer[i>=a_length?a_length-1:i];
-		pb = b->pointer[j>=b_length?b_length-1:j];
-		
-		if (pa == pb)
-		{
-			ba = !ba;
-			bb = !bb;
-			if ((ba && bb) != oldB)
-			{
-				arr->pointer[list++] = pa;
-			}
-			i++;
-			j++;
-		}
-		else if ((pa < pb || j >= b_length) && i < a_length)
-		{
-			ba = !ba;
-			if ((ba && bb) != oldB)
-				arr->pointer[list++] = pa;
-			i++;
-		}
-		else if (j < b_length)
+		group* const res = group_GcAlloc(gc);
+		mergeTo(groups[0], groups[1], table[0] & 0xF, res);
+		return res;
+	}
+	
+	return gcSweepFunction
+	(gc, n, groups, truthTableFunction, (void*)table, 0);
+}
+
+group* group_GcThreshold
+(gcstack* const gc, const int n, const group* const* const groups, 
+ const int threshold)
+{
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && groups == NULL);
+	macro_err_return_null(threshold < 1);
+	
+	int i;
+	for (i = 0; i < n; i++) {
+		macro_err_return_null(groups[i] == NULL);
+	}
+	
+	return gcSweepFunction(gc, n, groups, NULL, NULL, threshold);
+}
+
+int group_Contains(const group* const a, const int id)
+{
+	macro_err_return_zero(a == NULL);
+	
+	// The member is inside when an odd number of boundaries are at or 
+	// before it.
+	const int* const p = a->pointer;
+	int lo = 0, hi = a->length, mid;
+	while (lo < hi)
+	{
+		mid = lo + (hi-lo)/2;
+		if (p[mid] <= id)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo & 1;
+}
+
+int countLessOrEqual
+(const int* const p, const int n, const int bound, const int gallop);
+
+int countLessOrEqual
+(const int* const p, const int n, const int bound, const int gallop)
+{
+	if (bound == INT_MAX)
+		return n;
+	return gallop ? gallopCountLess(p, n, bound+1) : 
+	simd_CountLess(p, n, bound+1);
+}
+
+group* group_GcContainsMany
+(gcstack* const gc, const group* const a, const int n, 
+ const int* const ids)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(n < 0);
+	macro_err_return_null(n > 0 && ids == NULL);
+	
+	group* const res = group_InitWithSize(group_GcAlloc(gc), n+1);
+	
+	const int* const p = a->pointer;
+	const int len = a->length;
+	const int gallopA = len/GALLOP_RATIO > n;
+	const int gallopIds = n/GALLOP_RATIO > len;
+	
+	// Ids between two boundaries have the same state, so they are 
+	// skipped as a row, and boundaries between two ids are skipped too.
+	int i = 0, j = 0, k = 0;
+	int was = false;
+	int in;
+	while (i < n)
+	{
+		j += countLessOrEqual(p+j, len-j, ids[i], gallopA);
+		in = j & 1;
+		if (in != was)
 		{
-			bb = !bb;
-			if ((ba && bb) != oldB)
-				arr->pointer[list++] = pb;
-			j++;
+			res->pointer[k++] = i;
+			was = in;
 		}
-		else
-			break;
 		
-		oldB = ba && bb;
+		if (j == len)
+			break;
+		i += 1 + (gallopIds ? 
+			  gallopCountLess(ids+i+1, n-i-1, p[j]) : 
+			  simd_CountLess(ids+i+1, n-i-1, p[j]));
 	}
+	if (was)
+		res->pointer[k++] = n;
 	
-	return arr;
+	res->length = k;
+	if (k == 0)
+	{
+		free(res->pointer);
+		res->pointer = NULL;
+		res->capacity = 0;
+	}
+	
+	return res;
 }
 
+int group_AndSize(const group* const a, const group* const b)
+{
+	macro_err_return_zero(a == NULL);
+	macro_err_return_zero(b == NULL);
+	
+	return mergeSize(a->pointer, a->length, b->pointer, b->length, 
+			 MERGE_AND);
+}
+
+int group_OrSize(const group* const a, const group* const b)
+{
+	macro_err_return_zero(a == NULL);
+	macro_err_return_zero(b == NULL);
+	
+	return mergeSize(a->pointer, a->length, b->pointer, b->length, 
+			 MERGE_OR);
+}
+
+int group_ExceptSize(const group* const a, const group* const b)
+{
+	macro_err_return_zero(a == NULL);
+	macro_err_return_zero(b == NULL);
+	
+	return mergeSize(a->pointer, a->length, b->pointer, b->length, 
+			 MERGE_EXCEPT);
+}
+
+int group_OrManySize(const int n, const group* const* const groups)
+{
+	macro_err_return_zero(n < 0);
+	macro_err_return_zero(n > 0 && groups == NULL);
+	
+	int i;
+	for (i = 0; i < n; i++) {
+		macro_err_return_zero(groups[i] == NULL);
+	}
+	
+	return sweepFunction(n, groups, NULL, NULL, 1, NULL);
+}
+
+int group_AndManySize(const int n, const group* const* const groups)
+{
+	macro_err_return_zero(n < 0);
+	macro_err_return_zero(n > 0 && groups == NULL);
+	
+	int i;
+	for (i = 0; i < n; i++) {
+		macro_err_return_zero(groups[i] == NULL);
+	}
+	
+	return sweepFunction(n, groups, NULL, NULL, n == 0 ? 1 : n, NULL);
+}
 
 int group_Size(const group* const list)
 {
 	macro_err_return_zero(list == NULL);
 	
+	// The sum is computed with 64 bits so it can not overflow, and
+	// it stops at the largest int.
 	const int listCount = list->length;
-	int sum = 0;
+	long long sum = 0;
 	int i;
-	for (i = 0; i < listCount; i+=2)
+	for (i = 0; i+1 < listCount; i+=2)
 	{
-		sum += list->pointer[i+1]-list->pointer[i];
+		sum += (long long)list->pointer[i+1]-list->pointer[i];
 	}
-	return sum;
+	return sum > INT_MAX ? INT_MAX : (int)sum;
 }
 
-int absSub(const group* const list);
+long long absSub(const group* const list);
 
-int absSub(const group* const list)
+long long absSub(const group* const list)
 {
 	int i;
 	
@@ -1085,18 +2072,18 @@ int absSub(const group* const list)
 		// This means whatever the size of list is,
 		// the size of this vector is such and such
 		// less than the size.
-		int negSum = list->pointer[0];
+		long long negSum = list->pointer[0];
 		for (i = 1; i < listCount; i += 2)
 		{
-			negSum += list->pointer[i+1]-list->pointer[i];
+			negSum += (long long)list->pointer[i+1]-list->pointer[i];
 		}
 		return -negSum;
 	}
 	
-	int sum = 0;
+	long long sum = 0;
 	for (i = 0; i < listCount; i+=2)
 	{
-		sum += list->pointer[i+1]-list->pointer[i];
+		sum += (long long)list->pointer[i+1]-list->pointer[i];
 	}
 	return sum;
 }
@@ -1107,10 +2094,12 @@ int group_Abs(const group* const list, const int maximum)
 	
 	if (list->length == 0)
 		return 0;
-	const int abs = absSub(list);
+	long long abs = absSub(list);
 	if (abs <= 0)
-		return maximum+abs;
-	return abs;
+		abs += maximum;
+	
+	// Clamp to int, since the sum of blocks can be larger.
+	return abs > INT_MAX ? INT_MAX : abs < INT_MIN ? INT_MIN : (int)abs;
 }
 
 int* group_ArrayPointer(const group* const a)
@@ -1127,6 +2116,24 @@ int group_NumberOfBlocks(const group* const a)
 	return a->length/2;
 }
 
+void copyOnWrite(group* const a);
+
+//
+// Gives a read only view its own copy of the boundaries before it is
+// changed.
+//
+void copyOnWrite(group* const a)
+{
+	if (!a->readOnly)
+		return;
+	
+	int* const p = malloc(sizeof(int)*a->length);
+	memcpy(p, a->pointer, sizeof(int)*a->length);
+	a->pointer = p;
+	a->capacity = a->length;
+	a->readOnly = false;
+}
+
 int group_PopStart(group* const a)
 {
 	macro_err_return_zero(a == NULL);
@@ -1134,16 +2141,16 @@ int group_PopStart(group* const a)
 	const int length = a->length;
 	if (length < 2) return -1;
 	
-	// Move the start of the first block.
-	const int id = ++a->pointer[0];
+	copyOnWrite(a);
+	
+	// Move the start of the first block past the removed index.
+	const int id = a->pointer[0]++;
 	
 	// If the start crosses the end, then remove the block.
 	if (a->pointer[0] >= a->pointer[1])
 	{
 		// Instead of allocating we move the bytes 2 places toward beginning.
-		int i;
-		for (i = 2; i < length; i++)
-			a->pointer[i-2] = a->pointer[i];
+		memmove(a->pointer, a->pointer+2, sizeof(int)*(length-2));
 		a->length -= 2;
 	}
 	
@@ -1157,6 +2164,8 @@ int group_PopEnd(group* const a)
 	const int length = a->length;
 	if (length < 2) return -1;
 	
+	copyOnWrite(a);
+	
 	// Move the end.
 	const int id = --a->pointer[length-1];
 	
@@ -1179,15 +2188,14 @@ char** group_GetWords(group* const a, const char* const text)
 	int start, end;
 	int wordLength;
 	char* str;
-	int i, j;
+	int i;
 	for (i = 0; i < length; i++) {
 		start = a->pointer[i*2];
 		end = a->pointer[i*2+1];
 		wordLength = end - start;
 		
 		str = malloc((wordLength+1)*sizeof(char));
-		for (j = 0; j < wordLength; j++)
-			str[j] = text[start+j];
+		memcpy(str, text+start, wordLength);
 		str[wordLength] = '\0';
 		
 		arr[i] = str;
@@ -1195,3 +2203,164 @@ char** group_GetWords(group* const a, const char* const text)
 	
 	return arr;
 }
+
+char** group_GetWordsArena(const group* const a, const char* const text)
+{
+	macro_err_return_null(a == NULL);
+	
+	if (text == NULL) return NULL;
+	
+	const int length = a->length/2;
+	long long chars = 0;
+	int i;
+	for (i = 0; i < length; i++)
+		chars += a->pointer[i*2+1] - a->pointer[i*2] + 1;
+	
+	// The table of words comes first and the characters after it,
+	// so one call to free releases everything.
+	char** const arr = malloc(sizeof(char*)*length + chars);
+	char* str = (char*)(arr + length);
+	int start, wordLength;
+	for (i = 0; i < length; i++) {
+		start = a->pointer[i*2];
+		wordLength = a->pointer[i*2+1] - start;
+		memcpy(str, text+start, wordLength);
+		str[wordLength] = '\0';
+		arr[i] = str;
+		str += wordLength+1;
+	}
+	
+	return arr;
+}
+
+group_span* group_GetWordSpans(const group* const a)
+{
+	macro_err_return_null(a == NULL);
+	
+	const int length = a->length/2;
+	group_span* const spans = malloc(sizeof(group_span)*(length > 0 ? length : 1));
+	int i;
+	for (i = 0; i < length; i++) {
+		spans[i].offset = a->pointer[i*2];
+		spans[i].length = a->pointer[i*2+1] - a->pointer[i*2];
+	}
+	
+	return spans;
+}
+
+void group_ForEachRun
+(const group* const a, const group_run_function f, void* const data)
+{
+	macro_err_return(a == NULL);
+	macro_err_return(f == NULL);
+	
+	macro_bitstream_foreach_run (a) {
+		f(macro_bitstream_run_start(a), macro_bitstream_run_end(a), data);
+	} macro_bitstream_end_foreach_run(a)
+}
+
+//
+// The loops over a run have no dependencies between the iterations,
+// so the compiler turns them into vector instructions.
+//
+void group_FillDouble
+(const group* const a, double* const column, const double value)
+{
+	macro_err_return(a == NULL);
+	macro_err_return(column == NULL);
+	
+	int j, end;
+	macro_bitstream_foreach_run (a) {
+		end = macro_bitstream_run_end(a);
+		for (j = macro_bitstream_run_start(a); j < end; j++)
+			column[j] = value;
+	} macro_bitstream_end_foreach_run(a)
+}
+
+void group_FillInt
+(const group* const a, int* const column, const int value)
+{
+	macro_err_return(a == NULL);
+	macro_err_return(column == NULL);
+	
+	int j, end;
+	macro_bitstream_foreach_run (a) {
+		end = macro_bitstream_run_end(a);
+		for (j = macro_bitstream_run_start(a); j < end; j++)
+			column[j] = value;
+	} macro_bitstream_end_foreach_run(a)
+}
+
+int group_GatherDouble
+(const group* const a, const double* const column, 
+ double* const packed)
+{
+	macro_err_return_zero(a == NULL);
+	macro_err_return_zero(column == NULL);
+	macro_err_return_zero(packed == NULL);
+	
+	int k = 0, start, n;
+	macro_bitstream_foreach_run (a) {
+		start = macro_bitstream_run_start(a);
+		n = macro_bitstream_run_end(a) - start;
+		memcpy(packed+k, column+start, sizeof(double)*n);
+		k += n;
+	} macro_bitstream_end_foreach_run(a)
+	
+	return k;
+}
+
+int group_GatherInt
+(const group* const a, const int* const column, int* const packed)
+{
+	macro_err_return_zero(a == NULL);
+	macro_err_return_zero(column == NULL);
+	macro_err_return_zero(packed == NULL);
+	
+	int k = 0, start, n;
+	macro_bitstream_foreach_run (a) {
+		start = macro_bitstream_run_start(a);
+		n = macro_bitstream_run_end(a) - start;
+		memcpy(packed+k, column+start, sizeof(int)*n);
+		k += n;
+	} macro_bitstream_end_foreach_run(a)
+	
+	return k;
+}
+
+int group_ScatterDouble
+(const group* const a, const double* const packed, 
+ double* const column)
+{
+	macro_err_return_zero(a == NULL);
+	macro_err_return_zero(packed == NULL);
+	macro_err_return_zero(column == NULL);
+	
+	int k = 0, start, n;
+	macro_bitstream_foreach_run (a) {
+		start = macro_bitstream_run_start(a);
+		n = macro_bitstream_run_end(a) - start;
+		memcpy(column+start, packed+k, sizeof(double)*n);
+		k += n;
+	} macro_bitstream_end_foreach_run(a)
+	
+	return k;
+}
+
+int group_ScatterInt
+(const group* const a, const int* const packed, int* const column)
+{
+	macro_err_return_zero(a == NULL);
+	macro_err_return_zero(packed == NULL);
+	macro_err_return_zero(column == NULL);
+	
+	int k = 0, start, n;
+	macro_bitstream_foreach_run (a) {
+		start = macro_bitstream_run_start(a);
+		n = macro_bitstream_run_end(a) - start;
+		memcpy(column+start, packed+k, sizeof(int)*n);
+		k += n;
+	} macro_bitstream_end_foreach_run(a)
+	
+	return k;
+}
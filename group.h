@@ -78,6 +78,14 @@ extern "C" {
 		gcstack_item gc;
 		int length;
 		int* pointer;
+		
+		/* The number of ints allocated at pointer. */
+		int capacity;
+		
+		/* True if pointer refers to memory the bitstream does not own,
+		   such as a memory mapped file. It is not freed, and it is
+		   copied before the bitstream is changed. */
+		int readOnly;
 	} group;
 	
 	/*
@@ -126,6 +134,65 @@ extern "C" {
 	const void* const arrv, 
 	int (* const f)(const void* const p));
 	
+	/*
+		PREDICATE BUILDERS
+	
+		These initialize a bitstream with the positions in a column
+		of values where a condition is true. The values are compared
+		64 at a time with vector instructions into a bit mask, and the
+		boundaries are taken from the changes in the mask, so no
+		function is called per value and runs of equal results are
+		skipped a word at a time.
+		The bitstream grows on the heap, so any column size works.
+	*/
+	enum {
+		GROUP_LESS = 1,
+		GROUP_LESS_OR_EQUAL = 2,
+		GROUP_EQUAL = 3,
+		GROUP_NOT_EQUAL = 4,
+		GROUP_GREATER_OR_EQUAL = 5,
+		GROUP_GREATER = 6
+	};
+	
+	/*
+		Compares each value with 'value' using 'op', which is one of
+		the GROUP_LESS ... GROUP_GREATER constants.
+	*/
+	group* group_InitWithIntCompare
+	(group* const a, const int n, const int* const column, 
+	 const int op, const int value);
+	
+	/*
+		Takes the values where min <= value <= max.
+	*/
+	group* group_InitWithIntRange
+	(group* const a, const int n, const int* const column, 
+	 const int min, const int max);
+	
+	/*
+		NaN is only true for GROUP_NOT_EQUAL, like in C.
+	*/
+	group* group_InitWithDoubleCompare
+	(group* const a, const int n, const double* const column, 
+	 const int op, const double value);
+	
+	group* group_InitWithDoubleRange
+	(group* const a, const int n, const double* const column, 
+	 const double min, const double max);
+	
+	/*
+		Takes the values that are not zero.
+	*/
+	group* group_InitWithBoolColumn
+	(group* const a, const int n, const int* const column);
+	
+	/*
+		Takes the strings equal to 'value'. NULL equals only NULL.
+	*/
+	group* group_InitWithStringEquals
+	(group* const a, const int n, const char* const* const column, 
+	 const char* const value);
+	
 	/*
 		DELTA CHANGES
 	
@@ -167,6 +234,30 @@ extern "C" {
 	char** group_GetWords
 	(group* const a, const char* const text);
 	
+	/*
+		Like 'GetWords', but all words are copied into one block of
+		memory after the table of strings. Free the returned pointer
+		once, instead of freeing every word.
+	*/
+	char** group_GetWordsArena
+	(const group* const a, const char* const text);
+	
+	/*
+		The location of a word within a text, without copying it.
+	*/
+	typedef struct group_span {
+		int offset;
+		int length;
+	} group_span;
+	
+	/*
+		Returns the location of each word in the text the bitstream
+		was created from. The number of spans equals the number of
+		blocks. Free the returned array when done.
+	*/
+	group_span* group_GetWordSpans
+	(const group* const a);
+	
 	/*
 		Cleans up the structure within a bistream.
 		Frees up the pointer that is pointing to the data.
@@ -203,9 +294,9 @@ extern "C" {
 	/*
 		Performs an Boolean 'And' operation between two bitstreams.
 		This equal the intersection of amounts in a Venn diagram.
-		The algorithm first does a simulation of the computation
-		to figure out the needed size, then it does the actual job.
-		The simulation algorithm is hidden in the .c file as 'countAnd'.
+		The algorithm walks through both bitstreams once, writing to
+		a buffer with room for the worst case, which is shrinked
+		afterwards to fit the result.
 	*/
 	group* group_GcAnd
 	(gcstack* const gc, const group* const a, const group* const b);
@@ -213,9 +304,7 @@ extern "C" {
 	/*
 		Performs a Boolean 'Or' operation between two bitstreams.
 		This equals the sum of two amounts in a Venn diagram.
-		The algorithm first does a simulation of the computation
-		to figure out the needed size, then it does the actual job.
-		The simulation algorithm is hidden in the .c file as 'countOr'.
+		Like 'And', it is computed in a single pass.
 	*/
 	group* group_GcOr
 	(gcstack* const gc, const group* const a, const group* const b);
@@ -226,13 +315,60 @@ extern "C" {
 		If 'a' is the cookie, then 'b' is the teeth marks after chewing.
 		Instead of doing two operations, one NOT and one AND,
 		this algorithm is exact copy of 'And' except for changing a flag.
-		The algorihtm first does a simulation of the computation
-		to figure out the needed size, then it does the actual job.
-		The simulation algorithm is hidden in the .c file as 'countExcept'.
+		Like 'And', it is computed in a single pass.
 	*/
 	group* group_GcExcept
 	(gcstack* const gc, const group* const a, const group* const b);
 	
+	/*
+		PARALLEL OPERATIONS
+	
+		These compute the same as 'And', 'Or' and 'Except', but split
+		the bitstreams at the same boundary values and merge each part
+		on a thread of its own. 'threads' is the number of threads to
+		use, or 0 to use one per processor.
+		Small bitstreams are merged on the calling thread, because
+		starting threads costs more than it saves.
+	*/
+	group* group_GcParallelAnd
+	(gcstack* const gc, const group* const a, const group* const b, 
+	 const int threads);
+	
+	group* group_GcParallelOr
+	(gcstack* const gc, const group* const a, const group* const b, 
+	 const int threads);
+	
+	group* group_GcParallelExcept
+	(gcstack* const gc, const group* const a, const group* const b, 
+	 const int threads);
+	
+	/*
+		Returns the members of a bitstream in the range [start, end).
+		The boundaries inside the range are found with binary search,
+		so the cost grows with the size of the result, not the input.
+		Paging through a large bitstream does not walk the pages
+		before the one that is shown.
+	*/
+	group* group_GcSlice
+	(gcstack* const gc, const group* const a, const int start, const int end);
+	
+	/*
+		Performs 'And', 'Or' and 'Except' on the range [start, end) only.
+		This equals slicing the result of the full operation, but only
+		the boundaries inside the range are merged.
+	*/
+	group* group_GcAndRange
+	(gcstack* const gc, const group* const a, const group* const b, 
+	 const int start, const int end);
+	
+	group* group_GcOrRange
+	(gcstack* const gc, const group* const a, const group* const b, 
+	 const int start, const int end);
+	
+	group* group_GcExceptRange
+	(gcstack* const gc, const group* const a, const group* const b, 
+	 const int start, const int end);
+	
 	/*
 		Performs a Boolean 'Except' operation between two bitstreams.
 		It differs from 'bitstream_Except' by the way that the struct
@@ -242,6 +378,24 @@ extern "C" {
 	(const group* const a, 
 	 const group* const b, group* const tmp);
 	
+	/*
+		IN-PLACE OPERATIONS
+	
+		These change the first bitstream instead of allocating a new.
+		The buffer is reused when there is room for the result,
+		otherwise it grows to twice the capacity, so a bitstream that
+		is updated often will rarely need to allocate.
+		Boundaries before the first boundary in 'b' are not moved.
+	*/
+	void group_OrInPlace
+	(group* const a, const group* const b);
+	
+	void group_AndInPlace
+	(group* const a, const group* const b);
+	
+	void group_ExceptInPlace
+	(group* const a, const group* const b);
+	
 	/*
 		Performs an invert at a specified location in the bitstreams.
 		Because bitstream are infinite in both directions,
@@ -250,18 +404,131 @@ extern "C" {
 		Bitstreams that have odd length is inverted and infinite,
 		while those with even length is finite.
 		(bitstream is direct proof that there is infinite infinites).
-		The algorithm first does a simulation fo the computation
-		to figure out the needed size, then it does the actual job.
-		The simulation algorithm is hidden in the .c file as 'countInvert'.
+		The result got one number more or one less than the input,
+		so it is computed in a single pass.
 	*/
 	group* group_GcInvert
 	(gcstack* const gc, group* const a, const int inv);
 	
+	/*
+		Walks through all boundaries of many bitstreams in one sweep
+		and computes the result with a function of their states.
+		The function gets the number of bitstreams, the state of each
+		bitstream at the current position and the 'data' pointer.
+		It is called each time one or more of the states change, and
+		must return false when all the states are false.
+		'TruthTable', 'OrMany' and 'AndMany' are special cases.
+	*/
+	typedef int (*group_sweep_function)
+	(const int n, const int* const states, void* const data);
+	
+	group* group_GcSweep
+	(gcstack* const gc, const int n, const group* const* const groups, 
+	 const group_sweep_function f, void* const data);
+	
+	/*
+		Performs an 'Or' operation between many bitstreams at once.
+		Instead of chaining 'Or' calls, which allocates a bitstream
+		for each step, it walks through all boundaries in one sweep.
+		A heap picks the next boundary, and a counter tells how many
+		of the bitstreams that are true at that position.
+		Or is true where the counter is above zero.
+		This takes O(N log K) for N boundaries in K bitstreams.
+	*/
+	group* group_GcOrMany
+	(gcstack* const gc, const int n, const group* const* const groups);
+	
+	/*
+		Performs an 'And' operation between many bitstreams at once.
+		Like 'OrMany', it uses a single sweep, but it is true where
+		the counter equals the number of bitstreams.
+		It stops as soon as one finite bitstream is used up.
+	*/
+	group* group_GcAndMany
+	(gcstack* const gc, const int n, const group* const* const groups);
+	
+	/*
+		BOOLEAN FUNCTIONS OF MANY BITSTREAMS
+	
+		Any Boolean function of up to GROUP_TRUTH_TABLE_INPUTS
+		bitstreams is computed in a single sweep, like 'OrMany'.
+		The truth table has one bit for each combination of states,
+		stored 8 to a byte. The first bitstream is the highest bit of
+		the index, so for two bitstreams the MERGE_AND, MERGE_OR and
+		MERGE_EXCEPT tables in merge-kernel.h can be used, and they
+		are computed with the same merge as 'And', 'Or' and 'Except'.
+		Examples for three bitstreams a, b and c:
+	
+		a Xor b Xor c		0x96
+		majority		0xE8
+	
+		The function must be false when all bitstreams are false.
+	*/
+	enum {
+		GROUP_TRUTH_TABLE_INPUTS = 16
+	};
+	
+	group* group_GcTruthTable
+	(gcstack* const gc, const int n, const group* const* const groups, 
+	 const unsigned char* const table);
+	
+	/*
+		Returns the members of at least 'threshold' of the bitstreams.
+		'OrMany' is a threshold of 1 and 'AndMany' is a threshold of n.
+	*/
+	group* group_GcThreshold
+	(gcstack* const gc, const int n, const group* const* const groups, 
+	 const int threshold);
+	
+	/*
+		Returns true if 'id' is a member of the bitstream.
+		It uses binary search, so it takes O(log n) for n boundaries.
+		Inverted bitstreams are supported.
+	*/
+	int group_Contains
+	(const group* const a, const int id);
+	
+	/*
+		Tests many ids at once. The ids must be sorted.
+		Returns a bitstream of the positions in 'ids' that are members,
+		so position 'i' is in the result if ids[i] is in 'a'.
+		The ids and the boundaries are walked through together once,
+		skipping rows of either that do not change the result.
+	*/
+	group* group_GcContainsMany
+	(gcstack* const gc, const group* const a, const int n, 
+	 const int* const ids);
+	
+	/*
+		COUNTING OPERATIONS
+	
+		These return the size of the result of an operation without
+		creating it. They walk through the bitstreams the same way
+		as the operation itself, but nothing is allocated or written.
+		If the result is infinite, -1 is returned.
+	*/
+	int group_AndSize
+	(const group* const a, const group* const b);
+	
+	int group_OrSize
+	(const group* const a, const group* const b);
+	
+	int group_ExceptSize
+	(const group* const a, const group* const b);
+	
+	int group_OrManySize
+	(const int n, const group* const* const groups);
+	
+	int group_AndManySize
+	(const int n, const group* const* const groups);
+	
 	/*
 		Computes the area or size the bitstream covered with
 		true values. You can only use this if you have even length
 		of the bitstream, use 'bitstream_Abs' instead if you need
 		to support bitstreams ending in infinity.
+		If the size does not fit in an int, the largest int is returned.
+		Use group64.h for more than 2^31 members.
 	*/
 	int group_Size
 	(const group* const list);
@@ -293,6 +560,8 @@ extern "C" {
 		Removes and returns an index from the beginning of the 
 		bitstream. It is fast within a single block, but require extra 
 		operations at the end of each block.
+		Use a 'group_queue' to remove many indices from the beginning.
+		Returns -1 if the bitstream is empty.
 		Don't use it on inverted bitstreams.
 	*/
 	int group_PopStart
@@ -306,6 +575,57 @@ extern "C" {
 	int group_PopEnd
 	(group* const a);
 	
+	/*
+		RUN OPERATIONS
+	
+		These work on a whole block of members at a time, instead of
+		one member at a time like 'macro_bitstream_foreach'.
+		A column is an array indexed by member id, while a packed array
+		holds one value per member in the order of the bitstream.
+		The infinite block at the end of an inverted bitstream is
+		skipped.
+	*/
+	typedef void (*group_run_function)
+	(const int start, const int end, void* const data);
+	
+	/*
+		Calls 'f' for each block with the first member and the member
+		after the last.
+	*/
+	void group_ForEachRun
+	(const group* const a, const group_run_function f, void* const data);
+	
+	/*
+		Sets the column to a value for all members.
+	*/
+	void group_FillDouble
+	(const group* const a, double* const column, const double value);
+	
+	void group_FillInt
+	(const group* const a, int* const column, const int value);
+	
+	/*
+		Copies the values of the members from a column to a packed array.
+		Returns the number of values copied.
+	*/
+	int group_GatherDouble
+	(const group* const a, const double* const column, 
+	 double* const packed);
+	
+	int group_GatherInt
+	(const group* const a, const int* const column, int* const packed);
+	
+	/*
+		Copies the values from a packed array to the members of a column.
+		Returns the number of values copied.
+	*/
+	int group_ScatterDouble
+	(const group* const a, const double* const packed, 
+	 double* const column);
+	
+	int group_ScatterInt
+	(const group* const a, const int* const packed, int* const column);
+	
 #endif
 	
 #ifdef __cplusplus
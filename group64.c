@@ -0,0 +1,242 @@
+//
+//  group64.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "gcstack.h"
+#include "errorhandling.h"
+#include "readability.h"
+#include "merge-kernel.h"
+#include "group.h"
+
+#include "group64.h"
+
+macro_merge_kernel(group64, long long)
+
+void group64_Delete(void* const p)
+{
+	macro_err_return(p == NULL);
+
+	group64* const a = (group64* const)p;
+	free(a->pointer);
+	a->pointer = NULL;
+	a->length = 0;
+	a->capacity = 0;
+}
+
+group64* group64_GcAlloc(gcstack* const gc)
+{
+	return (group64*)gcstack_malloc
+	(gc, sizeof(group64), group64_Delete);
+}
+
+group64* group64_InitWithSize(group64* const a, const int size)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(size < 0);
+
+	// The gc item belongs to the gcstack, every other field is set here.
+	a->pointer = NULL;
+	a->length = 0;
+	a->capacity = 0;
+	if (size == 0)
+		return a;
+
+	// The boundaries are written by the caller, so they are not cleared.
+	a->pointer = malloc(sizeof(long long)*size);
+	a->length = size;
+	a->capacity = size;
+	return a;
+}
+
+group64* group64_InitWithValues
+(group64* const a, const int size, const long long* const vals)
+{
+	macro_err_return_null(vals == NULL && size > 0);
+
+	if (group64_InitWithSize(a, size) == NULL)
+		return NULL;
+
+	if (size > 0)
+		memcpy(a->pointer, vals, sizeof(long long)*size);
+	return a;
+}
+
+group64* group64_InitWithGroup(group64* const a, const group* const b)
+{
+	macro_err_return_null(b == NULL);
+
+	if (group64_InitWithSize(a, b->length) == NULL)
+		return NULL;
+
+	int i;
+	for (i = 0; i < b->length; i++)
+		a->pointer[i] = b->pointer[i];
+	return a;
+}
+
+void group64_Print(const group64* const a)
+{
+	macro_err_return(a == NULL);
+
+	int i;
+	for (i = 0; i+1 < a->length; i += 2)
+		printf("%lli,%lli ", a->pointer[i], a->pointer[i+1]);
+	printf("\r\n");
+}
+
+group64* group64_GcClone(gcstack* const gc, const group64* const a)
+{
+	macro_err_return_null(a == NULL);
+
+	return group64_InitWithValues(group64_GcAlloc(gc), a->length, a->pointer);
+}
+
+group64* merge64
+(gcstack* const gc, const group64* const a, const group64* const b,
+ const int table);
+
+group64* merge64
+(gcstack* const gc, const group64* const a, const group64* const b,
+ const int table)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	group64* const res = group64_GcAlloc(gc);
+	const int size = a->length + b->length;
+	if (size == 0)
+		return res;
+
+	long long* const buff = malloc(sizeof(long long)*size);
+	const int length = group64Merge
+	(a->pointer, a->length, false, b->pointer, b->length, false,
+	 table, buff);
+	if (length == 0)
+	{
+		free(buff);
+		return res;
+	}
+
+	res->length = length;
+	res->capacity = length;
+	res->pointer = length == size ? buff :
+	realloc(buff, sizeof(long long)*length);
+	return res;
+}
+
+group64* group64_GcAnd
+(gcstack* const gc, const group64* const a, const group64* const b)
+{
+	return merge64(gc, a, b, MERGE_AND);
+}
+
+group64* group64_GcOr
+(gcstack* const gc, const group64* const a, const group64* const b)
+{
+	return merge64(gc, a, b, MERGE_OR);
+}
+
+group64* group64_GcExcept
+(gcstack* const gc, const group64* const a, const group64* const b)
+{
+	return merge64(gc, a, b, MERGE_EXCEPT);
+}
+
+group64* group64_GcInvert
+(gcstack* const gc, const group64* const a, const long long inv)
+{
+	macro_err_return_null(a == NULL);
+
+	group64* const res = group64_InitWithSize
+	(group64_GcAlloc(gc), a->length+1);
+
+	// The boundary is removed if it is there, otherwise inserted.
+	const int k = group64CountLess(a->pointer, a->length, inv);
+	const int found = k < a->length && a->pointer[k] == inv;
+	if (k > 0)
+		memcpy(res->pointer, a->pointer, sizeof(long long)*k);
+
+	res->pointer[k] = inv;
+	const int rest = a->length - k - found;
+	if (rest > 0)
+		memcpy(res->pointer + k + !found, a->pointer + k + found,
+		       sizeof(long long)*rest);
+
+	res->length = k + !found + rest;
+	if (res->length == 0)
+	{
+		free(res->pointer);
+		res->pointer = NULL;
+		res->capacity = 0;
+	}
+	return res;
+}
+
+int group64_Contains(const group64* const a, const long long id)
+{
+	macro_err_return_zero(a == NULL);
+
+	const int k = group64CountLess(a->pointer, a->length, id);
+	return (k + (k < a->length && a->pointer[k] == id)) & 1;
+}
+
+unsigned long long size64
+(const long long* const p, const int from, const int to);
+
+//
+// Adds up the blocks from 'from' to 'to' without overflow.
+// The differences are computed as unsigned, which is exact, and the
+// sum stops at the largest long long.
+//
+unsigned long long size64
+(const long long* const p, const int from, const int to)
+{
+	unsigned long long sum = 0, d;
+	int i;
+	for (i = from; i+1 < to; i += 2)
+	{
+		d = (unsigned long long)p[i+1] - (unsigned long long)p[i];
+		if (d > (unsigned long long)LLONG_MAX - sum)
+			return LLONG_MAX;
+		sum += d;
+	}
+	return sum;
+}
+
+long long group64_Size(const group64* const a)
+{
+	macro_err_return_zero(a == NULL);
+
+	if (a->length % 2 != 0)
+		return -1;
+
+	return (long long)size64(a->pointer, 0, a->length);
+}
+
+long long group64_Abs(const group64* const a, const long long maximum)
+{
+	macro_err_return_zero(a == NULL);
+
+	if (a->length % 2 == 0)
+		return group64_Size(a);
+
+	// The inverted bitstream covers all from 0 to 'maximum' except
+	// before the first boundary and in the gaps.
+	const long long first = a->pointer[0];
+	unsigned long long missing = first > 0 ? (unsigned long long)first : 0;
+	const unsigned long long gaps = size64(a->pointer, 1, a->length);
+	missing = gaps > (unsigned long long)LLONG_MAX - missing ?
+	LLONG_MAX : missing + gaps;
+
+	if (maximum <= 0 || missing >= (unsigned long long)maximum)
+		return 0;
+	return maximum - (long long)missing;
+}
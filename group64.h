@@ -0,0 +1,94 @@
+//
+//  group64.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MemGroups_group64_h
+#define MemGroups_group64_h
+
+	//
+	//	64 BIT BITSTREAMS
+	//
+	//	These work like the bitstreams in group.h, but the boundaries
+	//	are 64 bit, so there can be more than 2^31 members.
+	//	The number of boundaries is still an int.
+	//	Use macro_bitstream_foreach64 to loop through the members.
+	//
+	typedef struct group64 {
+		gcstack_item gc;
+		int length;
+		long long* pointer;
+		int capacity;
+	} group64;
+
+	void group64_Delete
+	(void* const p);
+
+	group64* group64_GcAlloc
+	(gcstack* const gc);
+
+	//
+	// Initializes with room for a number of boundaries, like
+	// 'group_InitWithSize'. The length is set to 'size', but unlike
+	// the int version the boundaries are not cleared, so they must
+	// all be written through a->pointer before the bitstream is used.
+	//
+	group64* group64_InitWithSize
+	(group64* const a, const int size);
+
+	group64* group64_InitWithValues
+	(group64* const a, const int size, const long long* const vals);
+
+	//
+	// Initializes from a bitstream with int boundaries.
+	//
+	group64* group64_InitWithGroup
+	(group64* const a, const group* const b);
+
+	void group64_Print
+	(const group64* const a);
+
+	group64* group64_GcClone
+	(gcstack* const gc, const group64* const a);
+
+	group64* group64_GcAnd
+	(gcstack* const gc, const group64* const a, const group64* const b);
+
+	group64* group64_GcOr
+	(gcstack* const gc, const group64* const a, const group64* const b);
+
+	group64* group64_GcExcept
+	(gcstack* const gc, const group64* const a, const group64* const b);
+
+	group64* group64_GcInvert
+	(gcstack* const gc, const group64* const a, const long long inv);
+
+	int group64_Contains
+	(const group64* const a, const long long id);
+
+	//
+	// Returns the number of members, or -1 if the bitstream is
+	// infinite. If the number does not fit in a long long, the
+	// largest long long is returned.
+	//
+	long long group64_Size
+	(const group64* const a);
+
+	//
+	// Like 'group_Abs', an inverted bitstream counts the members
+	// from 0 up to 'maximum'. The result never overflows.
+	//
+	long long group64_Abs
+	(const group64* const a, const long long maximum);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
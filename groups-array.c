@@ -12,6 +12,7 @@
 #include "gcstack.h"
 #include "member.h"
 #include "group.h"
+#include "group-expr.h"
 #include "gop.h"
 #include "errorhandling.h"
 #include "readability.h"
@@ -48,14 +49,11 @@ void groups_array_SetDoubleArray
 	
 	gop_CreateBitstreamArray(g);
 	
-	// Update the bitstream, cleaning up manually for saving one malloc call.
+	// Update the bitstream in place, which reuses the buffer.
 	// It takes only one operation to update all.
 	int propIndex = propId%TYPE_STRIDE;
 	group* b = g->m_bitstreamsArray[propIndex];
-	group* c = group_GcOr(NULL, b, a);
-	gcstack_Swap(c, b);
-	group_Delete(b);
-	free(b);
+	group_OrInPlace(b, a);
 }
 
 void groups_array_SetStringArray
@@ -86,6 +84,8 @@ void groups_array_SetStringArray
 	macro_bitstream_foreach (a) {
 		i = macro_bitstream_pos(a);
 		obj = g->m_memberArray[i];
+		if (values[k] != NULL)
+			notDefaultIndices[notDefaultIndicesSize++] = i;
 		member_SetString(obj, propId, values[k++]);
 	} macro_bitstream_end_foreach(a)
 	
@@ -102,14 +102,22 @@ void groups_array_SetStringArray
 	group* notDef = group_InitWithIndices
 	(group_GcAlloc(gc), notDefaultIndicesSize, notDefaultIndices);
 	
-	// These are those who are default.
-	group* isDef = group_GcExcept(gc, a, notDef);
-	
-	// existing + notDef - (input - notDef)
-	group* c = group_GcExcept(gc, group_GcOr(gc, b, notDef), isDef);
+	// existing + notDef - (input - notDef), where (input - notDef) are
+	// those who are default. The expression is computed in one sweep
+	// without creating the bitstreams in between.
+	const group_expr* const existing = group_expr_GcLeaf(gc, b);
+	const group_expr* const input = group_expr_GcLeaf(gc, a);
+	const group_expr* const notDefExpr = group_expr_GcLeaf(gc, notDef);
+	const group_expr* const isDef = group_expr_GcExcept(gc, input, notDefExpr);
+	group* c = group_expr_GcEval(gc, group_expr_GcExcept
+	(gc, group_expr_GcOr(gc, existing, notDefExpr), isDef));
 	
 	gcstack_Swap(c, b);
 	
+	// The swap moves the new bitstream into the list of properties,
+	// so the array pointing to the old one must be built again.
+	g->m_bitstreamsReady = false;
+	
 	gcstack_Delete(gc);
 	free(gc);
 	
@@ -140,13 +148,15 @@ void groups_array_SetIntArray
 	// Later we convert it to a bitstream and use it for updating.
 	// The maximum size equals the array of values.
 	int* const notDefaultIndices = malloc(n*sizeof(int));
-	const int notDefaultIndicesSize = 0;
+	int notDefaultIndicesSize = 0;
 	
 	// We need an index to read properly from the values.
 	int k = 0;
 	macro_bitstream_foreach (a) {
 		i = macro_bitstream_pos(a);
 		obj = g->m_memberArray[i];
+		if (values[k] != -1)
+			notDefaultIndices[notDefaultIndicesSize++] = i;
 		member_SetInt(obj, propId, values[k++]);
 	} macro_bitstream_end_foreach(a)
 	
@@ -163,14 +173,22 @@ void groups_array_SetIntArray
 	group* notDef = group_InitWithIndices
 	(group_GcAlloc(gc), notDefaultIndicesSize, notDefaultIndices);
 	
-	// These are those who are default.
-	group* isDef = group_GcExcept(gc, a, notDef);
-	
-	// existing + notDef - (input - notDef)
-	group* c = group_GcExcept(gc, group_GcOr(gc, b, notDef), isDef);
+	// existing + notDef - (input - notDef), where (input - notDef) are
+	// those who are default. The expression is computed in one sweep
+	// without creating the bitstreams in between.
+	const group_expr* const existing = group_expr_GcLeaf(gc, b);
+	const group_expr* const input = group_expr_GcLeaf(gc, a);
+	const group_expr* const notDefExpr = group_expr_GcLeaf(gc, notDef);
+	const group_expr* const isDef = group_expr_GcExcept(gc, input, notDefExpr);
+	group* c = group_expr_GcEval(gc, group_expr_GcExcept
+	(gc, group_expr_GcOr(gc, existing, notDefExpr), isDef));
 	
 	gcstack_Swap(c, b);
 	
+	// The swap moves the new bitstream into the list of properties,
+	// so the array pointing to the old one must be built again.
+	g->m_bitstreamsReady = false;
+	
 	gcstack_Delete(gc);
 	free(gc);
 	
@@ -199,13 +217,15 @@ void groups_array_SetBoolArray
 	// Later we convert it to a bitstream and use it for updating.
 	// The maximum size equals the array of values.
 	int* const notDefaultIndices = malloc(n*sizeof(int));
-	const int notDefaultIndicesSize = 0;
+	int notDefaultIndicesSize = 0;
 	
 	// We need an index to read properly from the values.
 	int k = 0;
 	macro_bitstream_foreach (a) {
 		i = macro_bitstream_pos(a);
 		obj = g->m_memberArray[i];
+		if (values[k] != false)
+			notDefaultIndices[notDefaultIndicesSize++] = i;
 		member_SetBool(obj, propId, values[k++]);
 	} macro_bitstream_end_foreach(a)
 	
@@ -222,14 +242,22 @@ void groups_array_SetBoolArray
 	group* notDef = group_InitWithIndices
 	(group_GcAlloc(gc), notDefaultIndicesSize, notDefaultIndices);
 	
-	// These are those who are default.
-	group* isDef = group_GcExcept(gc, a, notDef);
-	
-	// existing + notDef - (input - notDef)
-	group* c = group_GcExcept(gc, group_GcOr(gc, b, notDef), isDef);
+	// existing + notDef - (input - notDef), where (input - notDef) are
+	// those who are default. The expression is computed in one sweep
+	// without creating the bitstreams in between.
+	const group_expr* const existing = group_expr_GcLeaf(gc, b);
+	const group_expr* const input = group_expr_GcLeaf(gc, a);
+	const group_expr* const notDefExpr = group_expr_GcLeaf(gc, notDef);
+	const group_expr* const isDef = group_expr_GcExcept(gc, input, notDefExpr);
+	group* c = group_expr_GcEval(gc, group_expr_GcExcept
+	(gc, group_expr_GcOr(gc, existing, notDefExpr), isDef));
 	
 	gcstack_Swap(c, b);
 	
+	// The swap moves the new bitstream into the list of properties,
+	// so the array pointing to the old one must be built again.
+	g->m_bitstreamsReady = false;
+	
 	gcstack_Delete(gc);
 	free(gc);
 	
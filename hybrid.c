@@ -0,0 +1,496 @@
+//
+//  hybrid.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+
+#include "gcstack.h"
+#include "errorhandling.h"
+#include "readability.h"
+#include "simd.h"
+#include "group.h"
+#include "bitmap.h"
+
+#include "hybrid.h"
+
+//
+// A chunk can have at most one block per two members, so this is
+// enough room for the boundaries of any chunk.
+//
+#define HYBRID_MAX_BOUNDARIES (HYBRID_CHUNK_SIZE + 2)
+
+enum {
+	HYBRID_AND = 1,
+	HYBRID_OR = 2,
+	HYBRID_EXCEPT = 3
+};
+
+void hybrid_Delete(void* const p)
+{
+	macro_err_return(p == NULL);
+
+	hybrid* const h = (hybrid* const)p;
+	int i;
+	for (i = 0; i < h->length; i++)
+		free(h->chunks[i].data);
+
+	free(h->chunks);
+	h->chunks = NULL;
+	h->length = 0;
+}
+
+hybrid* hybrid_GcAlloc(gcstack* const gc)
+{
+	return (hybrid*)gcstack_malloc
+	(gc, sizeof(hybrid), hybrid_Delete);
+}
+
+//
+// Fills a bitmap chunk with the members between boundaries.
+//
+void hybridBitmap_SetBoundaries
+(unsigned long long* const words, const int n, const int* const b);
+
+void hybridBitmap_SetBoundaries
+(unsigned long long* const words, const int n, const int* const b)
+{
+	int i;
+	memset(words, 0, sizeof(unsigned long long)*HYBRID_WORDS);
+	for (i = 0; i < n; i += 2)
+		bitmap_FillWords(words, HYBRID_WORDS, 0, b[i], b[i+1], true);
+}
+
+//
+// Writes the boundaries of a chunk relative to its start.
+//
+int hybridChunk_Boundaries
+(const hybrid_chunk* const c, int* const out);
+
+int hybridChunk_Boundaries
+(const hybrid_chunk* const c, int* const out)
+{
+	const unsigned short* s = (const unsigned short*)c->data;
+	int i, n = 0;
+	switch (c->kind) {
+		case HYBRID_RUNS:
+			for (i = 0; i < c->length; i++) {
+				out[n++] = s[2*i];
+				out[n++] = s[2*i+1] + 1;
+			}
+			return n;
+		case HYBRID_ARRAY:
+			for (i = 0; i < c->length; i++) {
+				// Members that follow each other share a block.
+				if (n > 0 && out[n-1] == s[i])
+					out[n-1]++;
+				else {
+					out[n++] = s[i];
+					out[n++] = s[i] + 1;
+				}
+			}
+			return n;
+		case HYBRID_BITMAP:
+			return bitmap_WordsToBoundaries
+			((const unsigned long long*)c->data, HYBRID_WORDS, 0, out);
+	}
+
+	macro_err_return_zero(c->kind != HYBRID_RUNS);
+	return 0;
+}
+
+//
+// Initializes a chunk from boundaries relative to its start.
+// Picks the form that takes least memory.
+// When a bitmap of the members is already computed, it can be passed
+// to save building it again.
+//
+void hybridChunk_InitWithBoundaries
+(hybrid_chunk* const c, const int key, const int n, const int* const b,
+ const unsigned long long* const words);
+
+void hybridChunk_InitWithBoundaries
+(hybrid_chunk* const c, const int key, const int n, const int* const b,
+ const unsigned long long* const words)
+{
+	macro_err_return(c == NULL);
+	macro_err_return(n < 0);
+
+	int i, j, k = 0, size = 0;
+	for (i = 0; i < n; i += 2)
+		size += b[i+1] - b[i];
+
+	const size_t runsBytes = 2*(size_t)n;
+	const size_t arrayBytes = size <= HYBRID_MAX_ARRAY ? 
+	2*(size_t)size : SIZE_MAX;
+	const size_t bitmapBytes = sizeof(unsigned long long)*HYBRID_WORDS;
+	unsigned short* s;
+
+	c->key = key;
+	c->size = size;
+
+	if (bitmapBytes < runsBytes && bitmapBytes < arrayBytes) {
+		c->kind = HYBRID_BITMAP;
+		c->length = HYBRID_WORDS;
+		c->data = malloc(bitmapBytes);
+		if (words != NULL)
+			memcpy(c->data, words, bitmapBytes);
+		else
+			hybridBitmap_SetBoundaries
+			((unsigned long long*)c->data, n, b);
+		return;
+	}
+
+	if (runsBytes <= arrayBytes) {
+		c->kind = HYBRID_RUNS;
+		c->length = n/2;
+		c->data = s = malloc(runsBytes);
+		for (i = 0; i < n; i += 2) {
+			s[i] = (unsigned short)b[i];
+			s[i+1] = (unsigned short)(b[i+1]-1);
+		}
+		return;
+	}
+
+	c->kind = HYBRID_ARRAY;
+	c->length = size;
+	c->data = s = malloc(arrayBytes);
+	for (i = 0; i < n; i += 2)
+		for (j = b[i]; j < b[i+1]; j++)
+			s[k++] = (unsigned short)j;
+}
+
+hybrid* hybrid_InitWithGroup(hybrid* const h, const group* const a)
+{
+	macro_err_return_null(h == NULL);
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(a->length % 2 != 0);
+	macro_err_return_null(a->length > 0 && a->pointer[0] < 0);
+
+	h->length = 0;
+	h->chunks = NULL;
+	if (a->length == 0)
+		return h;
+
+	// A chunk is needed for each key covered by a block.
+	const int* const p = a->pointer;
+	const int len = a->length;
+	int i, n, key, last = -1, count = 0;
+	for (i = 0; i < len; i += 2) {
+		key = p[i] / HYBRID_CHUNK_SIZE;
+		if (key <= last) key = last + 1;
+		last = (p[i+1]-1) / HYBRID_CHUNK_SIZE;
+		if (last >= key) count += last - key + 1;
+	}
+
+	h->chunks = malloc(sizeof(hybrid_chunk)*count);
+	int* const buf = malloc(sizeof(int)*HYBRID_MAX_BOUNDARIES);
+
+	// Cut the blocks at the chunk edges.
+	int start, end, base;
+	n = 0;
+	key = p[0] / HYBRID_CHUNK_SIZE;
+	for (i = 0; i < len; i += 2) {
+		start = p[i];
+		end = p[i+1];
+		while (start < end) {
+			if (start / HYBRID_CHUNK_SIZE != key) {
+				if (n > 0)
+					hybridChunk_InitWithBoundaries
+					(h->chunks + h->length++, key, n, buf, NULL);
+				n = 0;
+				key = start / HYBRID_CHUNK_SIZE;
+			}
+
+			base = key * HYBRID_CHUNK_SIZE;
+			buf[n++] = start - base;
+			if (end - base > HYBRID_CHUNK_SIZE) {
+				buf[n++] = HYBRID_CHUNK_SIZE;
+				start = base + HYBRID_CHUNK_SIZE;
+			} else {
+				buf[n++] = end - base;
+				start = end;
+			}
+		}
+	}
+
+	if (n > 0)
+		hybridChunk_InitWithBoundaries
+		(h->chunks + h->length++, key, n, buf, NULL);
+
+	free(buf);
+	return h;
+}
+
+group* hybrid_GcGroup(gcstack* const gc, const hybrid* const h)
+{
+	macro_err_return_null(h == NULL);
+
+	int i, j, k, n, base, total = 0;
+	for (i = 0; i < h->length; i++) {
+		switch (h->chunks[i].kind) {
+			case HYBRID_RUNS: total += 2*h->chunks[i].length; break;
+			case HYBRID_ARRAY: total += 2*h->chunks[i].size; break;
+			default: total += bitmap_CountWordBoundaries
+				((const unsigned long long*)h->chunks[i].data,
+				 HYBRID_WORDS);
+		}
+	}
+
+	group* const res = group_GcAlloc(gc);
+	group_InitWithSize(res, total);
+
+	int* const buf = malloc(sizeof(int)*HYBRID_MAX_BOUNDARIES);
+	k = 0;
+	for (i = 0; i < h->length; i++) {
+		n = hybridChunk_Boundaries(h->chunks+i, buf);
+		base = h->chunks[i].key * HYBRID_CHUNK_SIZE;
+		j = 0;
+
+		// A block that ends at the edge continues in the next chunk.
+		if (k > 0 && res->pointer[k-1] == base + buf[0]) {
+			k--;
+			j = 1;
+		}
+
+		for (; j < n; j++)
+			res->pointer[k++] = base + buf[j];
+	}
+
+	free(buf);
+	res->length = k;
+	if (k == 0) {
+		free(res->pointer);
+		res->pointer = NULL;
+		res->capacity = 0;
+	} else if (k < total) {
+		res->pointer = realloc(res->pointer, sizeof(int)*k);
+		res->capacity = k;
+	}
+
+	return res;
+}
+
+int hybrid_Size(const hybrid* const h)
+{
+	macro_err_return_zero(h == NULL);
+
+	int i, size = 0;
+	for (i = 0; i < h->length; i++)
+		size += h->chunks[i].size;
+
+	return size;
+}
+
+int hybridChunk_Bytes(const hybrid_chunk* const c);
+
+int hybridChunk_Bytes(const hybrid_chunk* const c)
+{
+	switch (c->kind) {
+		case HYBRID_RUNS: return 4*c->length;
+		case HYBRID_ARRAY: return 2*c->length;
+	}
+
+	return sizeof(unsigned long long)*HYBRID_WORDS;
+}
+
+int hybrid_Bytes(const hybrid* const h)
+{
+	macro_err_return_zero(h == NULL);
+
+	int i, bytes = 0;
+	for (i = 0; i < h->length; i++)
+		bytes += hybridChunk_Bytes(h->chunks + i);
+
+	return bytes;
+}
+
+//
+// Computes the bitmap of a chunk, or returns the chunk's own bitmap.
+//
+const unsigned long long* hybridChunk_Bitmap
+(const hybrid_chunk* const c, unsigned long long* const words,
+ int* const buf);
+
+const unsigned long long* hybridChunk_Bitmap
+(const hybrid_chunk* const c, unsigned long long* const words,
+ int* const buf)
+{
+	if (c->kind == HYBRID_BITMAP)
+		return (const unsigned long long*)c->data;
+
+	const int n = hybridChunk_Boundaries(c, buf);
+	hybridBitmap_SetBoundaries(words, n, buf);
+	return words;
+}
+
+//
+// Scratch space used when combining two chunks.
+//
+typedef struct hybrid_scratch {
+	int* a;
+	int* b;
+	unsigned long long* wa;
+	unsigned long long* wb;
+} hybrid_scratch;
+
+//
+// Combines two chunks with the same key into 'res'.
+// Returns false if the result is empty, and then nothing is allocated.
+//
+int hybridChunk_Merge
+(const hybrid_chunk* const ca, const hybrid_chunk* const cb,
+ const int op, hybrid_scratch* const tmp, hybrid_chunk* const res);
+
+int hybridChunk_Merge
+(const hybrid_chunk* const ca, const hybrid_chunk* const cb,
+ const int op, hybrid_scratch* const tmp, hybrid_chunk* const res)
+{
+	int n;
+
+	if (ca->kind == HYBRID_BITMAP || cb->kind == HYBRID_BITMAP) {
+		const unsigned long long* const wa =
+		hybridChunk_Bitmap(ca, tmp->wa, tmp->a);
+		const unsigned long long* const wb =
+		hybridChunk_Bitmap(cb, tmp->wb, tmp->a);
+		unsigned long long* const out = tmp->wa;
+		simd_Words(out, wa, wb, HYBRID_WORDS,
+			   op == HYBRID_AND ? SIMD_WORDS_AND :
+			   op == HYBRID_OR ? SIMD_WORDS_OR : SIMD_WORDS_ANDNOT);
+
+		n = bitmap_WordsToBoundaries(out, HYBRID_WORDS, 0, tmp->a);
+		if (n == 0) return false;
+
+		hybridChunk_InitWithBoundaries(res, ca->key, n, tmp->a, out);
+		return true;
+	}
+
+	group ga, gb;
+	ga.length = hybridChunk_Boundaries(ca, tmp->a);
+	ga.pointer = tmp->a;
+	gb.length = hybridChunk_Boundaries(cb, tmp->b);
+	gb.pointer = tmp->b;
+
+	group* const g =
+	op == HYBRID_AND ? group_GcAnd(NULL, &ga, &gb) :
+	op == HYBRID_OR ? group_GcOr(NULL, &ga, &gb) :
+	group_GcExcept(NULL, &ga, &gb);
+
+	n = g->length;
+	if (n > 0)
+		hybridChunk_InitWithBoundaries(res, ca->key, n, g->pointer, NULL);
+
+	group_Delete(g);
+	free(g);
+	return n > 0;
+}
+
+//
+// Copies a chunk that has no partner in the other operand.
+//
+void hybridChunk_Copy
+(const hybrid_chunk* const c, hybrid_chunk* const res);
+
+void hybridChunk_Copy
+(const hybrid_chunk* const c, hybrid_chunk* const res)
+{
+	const int bytes = hybridChunk_Bytes(c);
+	*res = *c;
+	res->data = malloc(bytes);
+	memcpy(res->data, c->data, bytes);
+}
+
+hybrid* hybridMerge
+(gcstack* const gc, const hybrid* const a, const hybrid* const b,
+ const int op);
+
+hybrid* hybridMerge
+(gcstack* const gc, const hybrid* const a, const hybrid* const b,
+ const int op)
+{
+	macro_err_return_null(a == NULL);
+	macro_err_return_null(b == NULL);
+
+	hybrid* const res = hybrid_GcAlloc(gc);
+	res->length = 0;
+	res->chunks = NULL;
+
+	const int max = op == HYBRID_AND ?
+	(a->length < b->length ? a->length : b->length) :
+	op == HYBRID_OR ? a->length + b->length : a->length;
+	if (max == 0)
+		return res;
+
+	res->chunks = malloc(sizeof(hybrid_chunk)*max);
+
+	hybrid_scratch tmp;
+	tmp.a = malloc(sizeof(int)*HYBRID_MAX_BOUNDARIES);
+	tmp.b = malloc(sizeof(int)*HYBRID_MAX_BOUNDARIES);
+	tmp.wa = malloc(sizeof(unsigned long long)*HYBRID_WORDS);
+	tmp.wb = malloc(sizeof(unsigned long long)*HYBRID_WORDS);
+
+	// The chunks are sorted by key, so walk both lists like a merge.
+	const hybrid_chunk* ca;
+	const hybrid_chunk* cb;
+	int i = 0, j = 0;
+	while (i < a->length || j < b->length) {
+		ca = i < a->length ? a->chunks + i : NULL;
+		cb = j < b->length ? b->chunks + j : NULL;
+		if (cb == NULL || (ca != NULL && ca->key < cb->key)) {
+			if (op != HYBRID_AND)
+				hybridChunk_Copy(ca, res->chunks + res->length++);
+			i++;
+		} else if (ca == NULL || cb->key < ca->key) {
+			if (op == HYBRID_OR)
+				hybridChunk_Copy(cb, res->chunks + res->length++);
+			else if (ca == NULL)
+				break;
+			j++;
+		} else {
+			if (hybridChunk_Merge(ca, cb, op, &tmp,
+					      res->chunks + res->length))
+				res->length++;
+			i++;
+			j++;
+		}
+
+		if (op == HYBRID_AND && (i == a->length || j == b->length))
+			break;
+	}
+
+	free(tmp.a);
+	free(tmp.b);
+	free(tmp.wa);
+	free(tmp.wb);
+
+	if (res->length == 0) {
+		free(res->chunks);
+		res->chunks = NULL;
+	}
+
+	return res;
+}
+
+hybrid* hybrid_GcAnd
+(gcstack* const gc, const hybrid* const a, const hybrid* const b)
+{
+	return hybridMerge(gc, a, b, HYBRID_AND);
+}
+
+hybrid* hybrid_GcOr
+(gcstack* const gc, const hybrid* const a, const hybrid* const b)
+{
+	return hybridMerge(gc, a, b, HYBRID_OR);
+}
+
+hybrid* hybrid_GcExcept
+(gcstack* const gc, const hybrid* const a, const hybrid* const b)
+{
+	return hybridMerge(gc, a, b, HYBRID_EXCEPT);
+}
@@ -0,0 +1,115 @@
+//
+//  hybrid.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MemGroups_hybrid_h
+#define MemGroups_hybrid_h
+
+	//
+	//	HYBRID GROUPS
+	//
+	//	A bitstream uses two numbers for every block, which is ideal
+	//	for long blocks but wasteful for members that are scattered.
+	//	A hybrid group splits the member ids into chunks of 65536 and
+	//	stores each chunk in the form that takes least memory:
+	//
+	//	Form		Memory		Good for
+	//	runs		4 per block	long blocks
+	//	array		2 per member	few scattered members
+	//	bitmap		8192		many scattered members
+	//
+	//	The form is picked again for each chunk after every operation,
+	//	so the memory stays bounded whatever the distribution is.
+	//	Use 'hybrid_GcGroup' to get a bitstream that works with
+	//	the group_Gc* operators and macro_bitstream_foreach.
+	//
+	enum {
+		HYBRID_CHUNK_SIZE = 65536,
+		HYBRID_WORDS = 1024,
+		HYBRID_MAX_ARRAY = 4096,
+		HYBRID_RUNS = 1,
+		HYBRID_ARRAY = 2,
+		HYBRID_BITMAP = 3
+	};
+
+	typedef struct hybrid_chunk {
+		/* The member id divided by HYBRID_CHUNK_SIZE. */
+		int key;
+		int kind;
+
+		/* Runs: number of blocks, array: number of members. */
+		int length;
+
+		/* Number of members in the chunk. */
+		int size;
+
+		/* Runs: start and last member of each block as unsigned short.
+		   Array: sorted member ids as unsigned short.
+		   Bitmap: HYBRID_WORDS 64 bit words. */
+		void* data;
+	} hybrid_chunk;
+
+	typedef struct hybrid {
+		gcstack_item gc;
+		int length;
+		hybrid_chunk* chunks;
+	} hybrid;
+
+	void hybrid_Delete
+	(void* const p);
+
+	hybrid* hybrid_GcAlloc
+	(gcstack* const gc);
+
+	//
+	// Initializes from a bitstream.
+	// The bitstream must be finite (even length) and contain no
+	// negative member ids.
+	//
+	hybrid* hybrid_InitWithGroup
+	(hybrid* const h, const group* const a);
+
+	//
+	// Creates a bitstream with the same members.
+	//
+	group* hybrid_GcGroup
+	(gcstack* const gc, const hybrid* const h);
+
+	//
+	// Returns the number of members. This is O(number of chunks).
+	//
+	int hybrid_Size
+	(const hybrid* const h);
+
+	//
+	// Returns the number of bytes used to store the chunks.
+	//
+	int hybrid_Bytes
+	(const hybrid* const h);
+
+	//
+	// The Boolean operators work chunk by chunk.
+	// Chunks where one side is a bitmap are computed word by word,
+	// the others are computed as bitstreams.
+	//
+	hybrid* hybrid_GcAnd
+	(gcstack* const gc, const hybrid* const a, const hybrid* const b);
+
+	hybrid* hybrid_GcOr
+	(gcstack* const gc, const hybrid* const a, const hybrid* const b);
+
+	hybrid* hybrid_GcExcept
+	(gcstack* const gc, const hybrid* const a, const hybrid* const b);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
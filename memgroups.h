@@ -50,6 +50,15 @@ extern "C" {
 	
 #include "gcstack.h"
 #include "group.h"
+#include "group-expr.h"
+#include "group-index.h"
+#include "group-map.h"
+#include "group-narrow.h"
+#include "group-queue.h"
+#include "group-serialize.h"
+#include "group64.h"
+#include "bitmap.h"
+#include "hybrid.h"
 #include "sorting.h"
 #include "member.h"
 #include "gop.h"
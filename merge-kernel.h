@@ -0,0 +1,155 @@
+//
+//  merge-kernel.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifndef MemGroups_merge_kernel_h
+#define MemGroups_merge_kernel_h
+
+//
+//	MERGE KERNELS
+//
+//	The Boolean operators are computed by walking through the
+//	boundaries of both bitstreams once. A truth table with 4 bits tells
+//	the result for each combination of states:
+//
+//	bit	a	b
+//	0	false	false
+//	1	false	true
+//	2	true	false
+//	3	true	true
+//
+//	Bit 0 must be 0, or the result would start in infinity.
+//
+#define MERGE_AND	0x8
+#define MERGE_OR	0xE
+#define MERGE_EXCEPT	0x4
+
+#define macro_merge_value(table, ba, bb) (((table) >> ((ba)*2+(bb))) & 1)
+
+//
+// The merge of int boundaries in group.c, with vectorized and
+// galloping search for rows. Other containers that store int
+// boundaries use it instead of generating their own.
+//
+int gallopCountLess(const int* const p, const int n, const int bound);
+
+int mergeBoundaries
+(const int* const A, const int al, const int startA,
+ const int* const B, const int bl, const int startB,
+ const int table, int* const out);
+
+//
+// Defines the merge for bitstreams with another type of boundaries
+// than int. It creates two functions:
+//
+// int <prefix>CountLess(const type* p, int n, type bound)
+// int <prefix>Merge(const type* A, int al, int startA,
+//                   const type* B, int bl, int startB,
+//                   int table, type* out)
+//
+// They work like 'gallopCountLess' and 'mergeBoundaries' in group.c,
+// except that rows are always found with galloping search, since the
+// vectorized search is only for int.
+//
+#define macro_merge_kernel(prefix, type)					\
+int prefix##CountLess(const type* const p, const int n, const type bound);	\
+										\
+int prefix##CountLess(const type* const p, const int n, const type bound)	\
+{										\
+	int lo = 0;								\
+	int hi = n < 1 ? n : 1;							\
+	int mid;								\
+	while (hi < n && p[hi-1] < bound)					\
+	{									\
+		lo = hi;							\
+		hi = hi*2 < n ? hi*2 : n;					\
+	}									\
+	while (lo < hi)								\
+	{									\
+		mid = lo + (hi-lo)/2;						\
+		if (p[mid] < bound)						\
+			lo = mid+1;						\
+		else								\
+			hi = mid;						\
+	}									\
+	return lo;								\
+}										\
+										\
+int prefix##Merge								\
+(const type* const A, const int al, const int startA,				\
+ const type* const B, const int bl, const int startB,				\
+ const int table, type* const out);						\
+										\
+int prefix##Merge								\
+(const type* const A, const int al, const int startA,				\
+ const type* const B, const int bl, const int startB,				\
+ const int table, type* const out)						\
+{										\
+	const int changesA[2] = {						\
+		macro_merge_value(table, 0, 0) != macro_merge_value(table, 1, 0),\
+		macro_merge_value(table, 0, 1) != macro_merge_value(table, 1, 1)\
+	};									\
+	const int changesB[2] = {						\
+		macro_merge_value(table, 0, 0) != macro_merge_value(table, 0, 1),\
+		macro_merge_value(table, 1, 0) != macro_merge_value(table, 1, 1)\
+	};									\
+										\
+	int i = 0, j = 0, k = 0;						\
+	int ba = startA;							\
+	int bb = startB;							\
+	int n;									\
+	type pa, pb;								\
+	while (i < al && j < bl)						\
+	{									\
+		pa = A[i];							\
+		pb = B[j];							\
+		if (pa < pb)							\
+		{								\
+			n = 1 + prefix##CountLess(A+i+1, al-i-1, pb);		\
+			if (changesA[bb])					\
+			{							\
+				memmove(out+k, A+i, n*sizeof(type));		\
+				k += n;						\
+			}							\
+			ba ^= n & 1;						\
+			i += n;							\
+		}								\
+		else if (pb < pa)						\
+		{								\
+			n = 1 + prefix##CountLess(B+j+1, bl-j-1, pa);		\
+			if (changesB[ba])					\
+			{							\
+				memcpy(out+k, B+j, n*sizeof(type));		\
+				k += n;						\
+			}							\
+			bb ^= n & 1;						\
+			j += n;							\
+		}								\
+		else								\
+		{								\
+			out[k] = pa;						\
+			k += macro_merge_value(table, ba, bb) !=		\
+			macro_merge_value(table, !ba, !bb);			\
+			ba = !ba;						\
+			bb = !bb;						\
+			i++;							\
+			j++;							\
+		}								\
+	}									\
+	if (i < al && changesA[bb])						\
+	{									\
+		memmove(out+k, A+i, (al-i)*sizeof(type));			\
+		k += al-i;							\
+	}									\
+	if (j < bl && changesB[ba])						\
+	{									\
+		memcpy(out+k, B+j, (bl-j)*sizeof(type));			\
+		k += bl-j;							\
+	}									\
+	return k;								\
+}
+
+#endif
@@ -117,6 +117,17 @@ extern "C" {
 		for (_macro_j##a = _macro_start##a;			\
 		_macro_j##a < _macro_end##a; _macro_j##a++) {
 
+/* For 64 bit bitstreams in group64.h. The other macroes are shared. */
+#define macro_bitstream_foreach64(a) 					\
+	int _macro_len##a = a->length-1, _macro_i##a; 			\
+	long long _macro_start##a, _macro_end##a, _macro_j##a; 	\
+	for (_macro_i##a = 0; 						\
+	_macro_i##a < _macro_len##a; _macro_i##a += 2) { 		\
+		_macro_start##a = a->pointer[_macro_i##a]; 		\
+		_macro_end##a = a->pointer[_macro_i##a+1]; 		\
+		for (_macro_j##a = _macro_start##a;			\
+		_macro_j##a < _macro_end##a; _macro_j##a++) {
+
 /* Add a dummy goto in order to remove compiler warning. */
 #define macro_bitstream_end_foreach(a) 					\
 	}} macro_bitstream_break(a); _macro_BREAK_BITSTREAM_##a:;
@@ -125,6 +136,37 @@ extern "C" {
 	
 #define macro_bitstream_pos(a)   	 _macro_j##a
 	
+	/*
+		RUN MACROES
+	
+		These visit a whole block of members at a time instead of one
+		member at a time, so the body can work on a range of memory.
+		The members of the current run go from 'macro_bitstream_run_start'
+		up to, but not including, 'macro_bitstream_run_end'.
+		An infinite block at the end of an inverted bitstream is skipped,
+		like in 'macro_bitstream_foreach'.
+	
+		macro_bitstream_foreach_run (bitstream) {
+			start = macro_bitstream_run_start(bitstream);
+			end = macro_bitstream_run_end(bitstream);
+			memset(flags + start, 1, end - start);
+		} macro_bitstream_end_foreach_run(bitstream)
+	
+		'macro_bitstream_break' works inside the loop too.
+	*/
+	
+#define macro_bitstream_foreach_run(a) 					\
+	int _macro_len##a = a->length-1, _macro_i##a; 			\
+	for (_macro_i##a = 0; 						\
+	_macro_i##a < _macro_len##a; _macro_i##a += 2) {
+	
+#define macro_bitstream_end_foreach_run(a) 				\
+	} macro_bitstream_break(a); _macro_BREAK_BITSTREAM_##a:;
+	
+#define macro_bitstream_run_start(a)	a->pointer[_macro_i##a]
+	
+#define macro_bitstream_run_end(a)	a->pointer[_macro_i##a+1]
+	
 	/*
 		FOR EACH - DESIGNED FOR HASH TABLE
 	*/
@@ -0,0 +1,675 @@
+//
+//  simd.c
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "errorhandling.h"
+#include "readability.h"
+
+#include "simd.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+(defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+int countLessScalar(const int* const p, const int n, const int bound);
+
+int countLessScalar(const int* const p, const int n, const int bound)
+{
+	int k;
+	for (k = 0; k < n && p[k] < bound; k++);
+	return k;
+}
+
+#if SIMD_X86
+
+int countLessSSE2(const int* const p, const int n, const int bound);
+
+__attribute__((target("sse2")))
+int countLessSSE2(const int* const p, const int n, const int bound)
+{
+	const __m128i b = _mm_set1_epi32(bound);
+	__m128i v;
+	int mask;
+	int k;
+	for (k = 0; k+4 <= n; k += 4) {
+		v = _mm_loadu_si128((const __m128i*)(p+k));
+		
+		// The array is sorted, so the mask is a row of ones followed
+		// by zeros. The first zero tells where to stop.
+		mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(b, v)));
+		if (mask != 0xF)
+			return k + __builtin_ctz(~mask);
+	}
+	return k + countLessScalar(p+k, n-k, bound);
+}
+
+int countLessAVX2(const int* const p, const int n, const int bound);
+
+__attribute__((target("avx2")))
+int countLessAVX2(const int* const p, const int n, const int bound)
+{
+	const __m256i b = _mm256_set1_epi32(bound);
+	__m256i v;
+	int mask;
+	int k;
+	for (k = 0; k+8 <= n; k += 8) {
+		v = _mm256_loadu_si256((const __m256i*)(p+k));
+		mask = _mm256_movemask_ps
+		(_mm256_castsi256_ps(_mm256_cmpgt_epi32(b, v)));
+		if (mask != 0xFF)
+			return k + __builtin_ctz(~mask);
+	}
+	return k + countLessScalar(p+k, n-k, bound);
+}
+
+#endif
+
+//
+// The bitmap kernels combine 64 bit words.
+// 'op' is one of the SIMD_WORDS_* constants.
+//
+void wordsScalar
+(unsigned long long* const out, const unsigned long long* const a,
+ const unsigned long long* const b, const int n, const int op);
+
+void wordsScalar
+(unsigned long long* const out, const unsigned long long* const a,
+ const unsigned long long* const b, const int n, const int op)
+{
+	int i;
+	switch (op) {
+		case SIMD_WORDS_AND:
+			for (i = 0; i < n; i++) out[i] = a[i] & b[i];
+			break;
+		case SIMD_WORDS_OR:
+			for (i = 0; i < n; i++) out[i] = a[i] | b[i];
+			break;
+		case SIMD_WORDS_ANDNOT:
+			for (i = 0; i < n; i++) out[i] = a[i] & ~b[i];
+			break;
+	}
+}
+
+int popCountScalar(const unsigned long long* const p, const int n);
+
+int popCountScalar(const unsigned long long* const p, const int n)
+{
+	int i, count = 0;
+	for (i = 0; i < n; i++)
+		count += __builtin_popcountll(p[i]);
+	return count;
+}
+
+void rangeMaskIntScalar
+(const int* const p, const int n, const int lo, const int hi,
+ unsigned long long* const mask);
+
+void rangeMaskIntScalar
+(const int* const p, const int n, const int lo, const int hi,
+ unsigned long long* const mask)
+{
+	int i;
+	for (i = 0; i < (n+63)/64; i++)
+		mask[i] = 0;
+	for (i = 0; i < n; i++)
+		mask[i >> 6] |= (unsigned long long)(p[i] >= lo && p[i] <= hi) 
+		<< (i & 63);
+}
+
+void rangeMaskDoubleScalar
+(const double* const p, const int n, const double lo, const double hi,
+ unsigned long long* const mask);
+
+void rangeMaskDoubleScalar
+(const double* const p, const int n, const double lo, const double hi,
+ unsigned long long* const mask)
+{
+	int i;
+	for (i = 0; i < (n+63)/64; i++)
+		mask[i] = 0;
+	for (i = 0; i < n; i++)
+		mask[i >> 6] |= (unsigned long long)(p[i] >= lo && p[i] <= hi) 
+		<< (i & 63);
+}
+
+void diffMaskIntScalar
+(const int* const a, const int* const b, const int n,
+ unsigned long long* const mask);
+
+void diffMaskIntScalar
+(const int* const a, const int* const b, const int n,
+ unsigned long long* const mask)
+{
+	int i;
+	for (i = 0; i < (n+63)/64; i++)
+		mask[i] = 0;
+	for (i = 0; i < n; i++)
+		mask[i >> 6] |= (unsigned long long)(a[i] != b[i]) << (i & 63);
+}
+
+void diffMaskDoubleScalar
+(const double* const a, const double* const b, const int n,
+ unsigned long long* const mask);
+
+void diffMaskDoubleScalar
+(const double* const a, const double* const b, const int n,
+ unsigned long long* const mask)
+{
+	int i;
+	for (i = 0; i < (n+63)/64; i++)
+		mask[i] = 0;
+	for (i = 0; i < n; i++)
+		mask[i >> 6] |= (unsigned long long)(a[i] != b[i]) << (i & 63);
+}
+
+void byteMaskScalar
+(const unsigned char* const p, const int n, 
+ const unsigned char* const lo, const unsigned char* const hi,
+ unsigned long long* const mask);
+
+void byteMaskScalar
+(const unsigned char* const p, const int n, 
+ const unsigned char* const lo, const unsigned char* const hi,
+ unsigned long long* const mask)
+{
+	int i;
+	for (i = 0; i < (n+63)/64; i++)
+		mask[i] = 0;
+	for (i = 0; i < n; i++)
+		mask[i >> 6] |= (unsigned long long)
+		((lo[p[i] & 15] & hi[p[i] >> 4]) != 0) << (i & 63);
+}
+
+#if SIMD_X86
+
+void wordsSSE2
+(unsigned long long* const out, const unsigned long long* const a,
+ const unsigned long long* const b, const int n, const int op);
+
+__attribute__((target("sse2")))
+void wordsSSE2
+(unsigned long long* const out, const unsigned long long* const a,
+ const unsigned long long* const b, const int n, const int op)
+{
+	__m128i va, vb;
+	int i;
+	for (i = 0; i+2 <= n; i += 2) {
+		va = _mm_loadu_si128((const __m128i*)(a+i));
+		vb = _mm_loadu_si128((const __m128i*)(b+i));
+		
+		// andnot computes ~first & second, so 'b' goes first.
+		va = op == SIMD_WORDS_AND ? _mm_and_si128(va, vb) :
+		op == SIMD_WORDS_OR ? _mm_or_si128(va, vb) :
+		_mm_andnot_si128(vb, va);
+		_mm_storeu_si128((__m128i*)(out+i), va);
+	}
+	wordsScalar(out+i, a+i, b+i, n-i, op);
+}
+
+void wordsAVX2
+(unsigned long long* const out, const unsigned long long* const a,
+ const unsigned long long* const b, const int n, const int op);
+
+__attribute__((target("avx2")))
+void wordsAVX2
+(unsigned long long* const out, const unsigned long long* const a,
+ const unsigned long long* const b, const int n, const int op)
+{
+	__m256i va, vb;
+	int i;
+	for (i = 0; i+4 <= n; i += 4) {
+		va = _mm256_loadu_si256((const __m256i*)(a+i));
+		vb = _mm256_loadu_si256((const __m256i*)(b+i));
+		va = op == SIMD_WORDS_AND ? _mm256_and_si256(va, vb) :
+		op == SIMD_WORDS_OR ? _mm256_or_si256(va, vb) :
+		_mm256_andnot_si256(vb, va);
+		_mm256_storeu_si256((__m256i*)(out+i), va);
+	}
+	wordsScalar(out+i, a+i, b+i, n-i, op);
+}
+
+int popCountPOPCNT(const unsigned long long* const p, const int n);
+
+__attribute__((target("popcnt")))
+int popCountPOPCNT(const unsigned long long* const p, const int n)
+{
+	int i, count = 0;
+	for (i = 0; i < n; i++)
+		count += __builtin_popcountll(p[i]);
+	return count;
+}
+
+//
+// The range kernels fill one word at a time from whole vectors and
+// leave the values after the last full word to the scalar version.
+// A value is outside when lo > v or v > hi.
+//
+void rangeMaskIntSSE2
+(const int* const p, const int n, const int lo, const int hi,
+ unsigned long long* const mask);
+
+__attribute__((target("sse2")))
+void rangeMaskIntSSE2
+(const int* const p, const int n, const int lo, const int hi,
+ unsigned long long* const mask)
+{
+	const __m128i vlo = _mm_set1_epi32(lo);
+	const __m128i vhi = _mm_set1_epi32(hi);
+	__m128i v, out;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 4) {
+			v = _mm_loadu_si128((const __m128i*)(p+i+j));
+			out = _mm_or_si128(_mm_cmpgt_epi32(vlo, v), 
+							   _mm_cmpgt_epi32(v, vhi));
+			w |= (unsigned long long)
+			(~_mm_movemask_ps(_mm_castsi128_ps(out)) & 0xF) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	rangeMaskIntScalar(p+i, n-i, lo, hi, mask + (i >> 6));
+}
+
+void rangeMaskIntAVX2
+(const int* const p, const int n, const int lo, const int hi,
+ unsigned long long* const mask);
+
+__attribute__((target("avx2")))
+void rangeMaskIntAVX2
+(const int* const p, const int n, const int lo, const int hi,
+ unsigned long long* const mask)
+{
+	const __m256i vlo = _mm256_set1_epi32(lo);
+	const __m256i vhi = _mm256_set1_epi32(hi);
+	__m256i v, out;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 8) {
+			v = _mm256_loadu_si256((const __m256i*)(p+i+j));
+			out = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, v), 
+								  _mm256_cmpgt_epi32(v, vhi));
+			w |= (unsigned long long)
+			(~_mm256_movemask_ps(_mm256_castsi256_ps(out)) & 0xFF) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	rangeMaskIntScalar(p+i, n-i, lo, hi, mask + (i >> 6));
+}
+
+void rangeMaskDoubleSSE2
+(const double* const p, const int n, const double lo, const double hi,
+ unsigned long long* const mask);
+
+__attribute__((target("sse2")))
+void rangeMaskDoubleSSE2
+(const double* const p, const int n, const double lo, const double hi,
+ unsigned long long* const mask)
+{
+	const __m128d vlo = _mm_set1_pd(lo);
+	const __m128d vhi = _mm_set1_pd(hi);
+	__m128d v, in;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 2) {
+			v = _mm_loadu_pd(p+i+j);
+			
+			// The ordered compares are false for NaN.
+			in = _mm_and_pd(_mm_cmpge_pd(v, vlo), _mm_cmple_pd(v, vhi));
+			w |= (unsigned long long)_mm_movemask_pd(in) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	rangeMaskDoubleScalar(p+i, n-i, lo, hi, mask + (i >> 6));
+}
+
+void rangeMaskDoubleAVX2
+(const double* const p, const int n, const double lo, const double hi,
+ unsigned long long* const mask);
+
+__attribute__((target("avx2")))
+void rangeMaskDoubleAVX2
+(const double* const p, const int n, const double lo, const double hi,
+ unsigned long long* const mask)
+{
+	const __m256d vlo = _mm256_set1_pd(lo);
+	const __m256d vhi = _mm256_set1_pd(hi);
+	__m256d v, in;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 4) {
+			v = _mm256_loadu_pd(p+i+j);
+			in = _mm256_and_pd(_mm256_cmp_pd(v, vlo, _CMP_GE_OQ), 
+							   _mm256_cmp_pd(v, vhi, _CMP_LE_OQ));
+			w |= (unsigned long long)_mm256_movemask_pd(in) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	rangeMaskDoubleScalar(p+i, n-i, lo, hi, mask + (i >> 6));
+}
+
+
+void diffMaskIntSSE2
+(const int* const a, const int* const b, const int n,
+ unsigned long long* const mask);
+
+__attribute__((target("sse2")))
+void diffMaskIntSSE2
+(const int* const a, const int* const b, const int n,
+ unsigned long long* const mask)
+{
+	__m128i va, vb;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 4) {
+			va = _mm_loadu_si128((const __m128i*)(a+i+j));
+			vb = _mm_loadu_si128((const __m128i*)(b+i+j));
+			w |= (unsigned long long)(~_mm_movemask_ps
+			(_mm_castsi128_ps(_mm_cmpeq_epi32(va, vb))) & 0xF) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	diffMaskIntScalar(a+i, b+i, n-i, mask + (i >> 6));
+}
+
+void diffMaskIntAVX2
+(const int* const a, const int* const b, const int n,
+ unsigned long long* const mask);
+
+__attribute__((target("avx2")))
+void diffMaskIntAVX2
+(const int* const a, const int* const b, const int n,
+ unsigned long long* const mask)
+{
+	__m256i va, vb;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 8) {
+			va = _mm256_loadu_si256((const __m256i*)(a+i+j));
+			vb = _mm256_loadu_si256((const __m256i*)(b+i+j));
+			w |= (unsigned long long)(~_mm256_movemask_ps
+			(_mm256_castsi256_ps(_mm256_cmpeq_epi32(va, vb))) & 0xFF) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	diffMaskIntScalar(a+i, b+i, n-i, mask + (i >> 6));
+}
+
+void diffMaskDoubleSSE2
+(const double* const a, const double* const b, const int n,
+ unsigned long long* const mask);
+
+__attribute__((target("sse2")))
+void diffMaskDoubleSSE2
+(const double* const a, const double* const b, const int n,
+ unsigned long long* const mask)
+{
+	__m128d va, vb;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 2) {
+			va = _mm_loadu_pd(a+i+j);
+			vb = _mm_loadu_pd(b+i+j);
+			
+			// The unordered compare is true for NaN.
+			w |= (unsigned long long)_mm_movemask_pd
+			(_mm_cmpneq_pd(va, vb)) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	diffMaskDoubleScalar(a+i, b+i, n-i, mask + (i >> 6));
+}
+
+void diffMaskDoubleAVX2
+(const double* const a, const double* const b, const int n,
+ unsigned long long* const mask);
+
+__attribute__((target("avx2")))
+void diffMaskDoubleAVX2
+(const double* const a, const double* const b, const int n,
+ unsigned long long* const mask)
+{
+	__m256d va, vb;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 4) {
+			va = _mm256_loadu_pd(a+i+j);
+			vb = _mm256_loadu_pd(b+i+j);
+			w |= (unsigned long long)_mm256_movemask_pd
+			(_mm256_cmp_pd(va, vb, _CMP_NEQ_UQ)) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	diffMaskDoubleScalar(a+i, b+i, n-i, mask + (i >> 6));
+}
+
+
+//
+// The byte kernels look up both halves of each byte in the tables
+// and mark the bytes where the results have a bit in common.
+//
+void byteMaskSSSE3
+(const unsigned char* const p, const int n, 
+ const unsigned char* const lo, const unsigned char* const hi,
+ unsigned long long* const mask);
+
+__attribute__((target("ssse3")))
+void byteMaskSSSE3
+(const unsigned char* const p, const int n, 
+ const unsigned char* const lo, const unsigned char* const hi,
+ unsigned long long* const mask)
+{
+	const __m128i tlo = _mm_loadu_si128((const __m128i*)lo);
+	const __m128i thi = _mm_loadu_si128((const __m128i*)hi);
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i v, c;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 16) {
+			v = _mm_loadu_si128((const __m128i*)(p+i+j));
+			c = _mm_and_si128
+			(_mm_shuffle_epi8(tlo, _mm_and_si128(v, nibble)),
+			 _mm_shuffle_epi8(thi, _mm_and_si128(_mm_srli_epi16(v, 4), nibble)));
+			w |= (unsigned long long)
+			(~_mm_movemask_epi8(_mm_cmpeq_epi8(c, zero)) & 0xFFFF) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	byteMaskScalar(p+i, n-i, lo, hi, mask + (i >> 6));
+}
+
+void byteMaskAVX2
+(const unsigned char* const p, const int n, 
+ const unsigned char* const lo, const unsigned char* const hi,
+ unsigned long long* const mask);
+
+__attribute__((target("avx2")))
+void byteMaskAVX2
+(const unsigned char* const p, const int n, 
+ const unsigned char* const lo, const unsigned char* const hi,
+ unsigned long long* const mask)
+{
+	// The shuffle works within each half of the register,
+	// so the tables are copied to both halves.
+	const __m256i tlo = _mm256_broadcastsi128_si256
+	(_mm_loadu_si128((const __m128i*)lo));
+	const __m256i thi = _mm256_broadcastsi128_si256
+	(_mm_loadu_si128((const __m128i*)hi));
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i v, c;
+	unsigned long long w;
+	int i, j;
+	for (i = 0; i+64 <= n; i += 64) {
+		w = 0;
+		for (j = 0; j < 64; j += 32) {
+			v = _mm256_loadu_si256((const __m256i*)(p+i+j));
+			c = _mm256_and_si256
+			(_mm256_shuffle_epi8(tlo, _mm256_and_si256(v, nibble)),
+			 _mm256_shuffle_epi8
+			 (thi, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)));
+			w |= (unsigned long long)(unsigned int)
+			~_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, zero)) << j;
+		}
+		mask[i >> 6] = w;
+	}
+	byteMaskScalar(p+i, n-i, lo, hi, mask + (i >> 6));
+}
+
+#endif
+
+int (* m_countLess)(const int* const p, const int n, const int bound) = NULL;
+void (* m_words)
+(unsigned long long* const out, const unsigned long long* const a,
+ const unsigned long long* const b, const int n, const int op) = NULL;
+int (* m_popCount)(const unsigned long long* const p, const int n) = NULL;
+void (* m_rangeMaskInt)
+(const int* const p, const int n, const int lo, const int hi,
+ unsigned long long* const mask) = NULL;
+void (* m_rangeMaskDouble)
+(const double* const p, const int n, const double lo, const double hi,
+ unsigned long long* const mask) = NULL;
+void (* m_diffMaskInt)
+(const int* const a, const int* const b, const int n,
+ unsigned long long* const mask) = NULL;
+void (* m_diffMaskDouble)
+(const double* const a, const double* const b, const int n,
+ unsigned long long* const mask) = NULL;
+void (* m_byteMask)
+(const unsigned char* const p, const int n, 
+ const unsigned char* const lo, const unsigned char* const hi,
+ unsigned long long* const mask) = NULL;
+pthread_once_t m_simdOnce = PTHREAD_ONCE_INIT;
+
+void simd_SelectKernels(void);
+
+void simd_SelectKernels(void)
+{
+	m_countLess = countLessScalar;
+	m_words = wordsScalar;
+	m_popCount = popCountScalar;
+	m_rangeMaskInt = rangeMaskIntScalar;
+	m_rangeMaskDouble = rangeMaskDoubleScalar;
+	m_diffMaskInt = diffMaskIntScalar;
+	m_diffMaskDouble = diffMaskDoubleScalar;
+	m_byteMask = byteMaskScalar;
+	
+#if SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		m_countLess = countLessAVX2;
+		m_words = wordsAVX2;
+		m_rangeMaskInt = rangeMaskIntAVX2;
+		m_rangeMaskDouble = rangeMaskDoubleAVX2;
+		m_diffMaskInt = diffMaskIntAVX2;
+		m_diffMaskDouble = diffMaskDoubleAVX2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		m_countLess = countLessSSE2;
+		m_words = wordsSSE2;
+		m_rangeMaskInt = rangeMaskIntSSE2;
+		m_rangeMaskDouble = rangeMaskDoubleSSE2;
+		m_diffMaskInt = diffMaskIntSSE2;
+		m_diffMaskDouble = diffMaskDoubleSSE2;
+	}
+	
+	if (__builtin_cpu_supports("avx2"))
+		m_byteMask = byteMaskAVX2;
+	else if (__builtin_cpu_supports("ssse3"))
+		m_byteMask = byteMaskSSSE3;
+	
+	if (__builtin_cpu_supports("popcnt"))
+		m_popCount = popCountPOPCNT;
+#endif
+}
+
+int simd_CountLess(const int* const p, const int n, const int bound)
+{
+	pthread_once(&m_simdOnce, simd_SelectKernels);
+	return m_countLess(p, n, bound);
+}
+
+void simd_Words
+(unsigned long long* const out, const unsigned long long* const a,
+ const unsigned long long* const b, const int n, const int op)
+{
+	macro_err_return(op < SIMD_WORDS_AND || op > SIMD_WORDS_ANDNOT);
+	
+	pthread_once(&m_simdOnce, simd_SelectKernels);
+	m_words(out, a, b, n, op);
+}
+
+int simd_PopCount(const unsigned long long* const p, const int n)
+{
+	pthread_once(&m_simdOnce, simd_SelectKernels);
+	return m_popCount(p, n);
+}
+
+void simd_RangeMaskInt
+(const int* const p, const int n, const int lo, const int hi,
+ unsigned long long* const mask)
+{
+	pthread_once(&m_simdOnce, simd_SelectKernels);
+	m_rangeMaskInt(p, n, lo, hi, mask);
+}
+
+void simd_RangeMaskDouble
+(const double* const p, const int n, const double lo, const double hi,
+ unsigned long long* const mask)
+{
+	pthread_once(&m_simdOnce, simd_SelectKernels);
+	m_rangeMaskDouble(p, n, lo, hi, mask);
+}
+
+void simd_DiffMaskInt
+(const int* const a, const int* const b, const int n,
+ unsigned long long* const mask)
+{
+	pthread_once(&m_simdOnce, simd_SelectKernels);
+	m_diffMaskInt(a, b, n, mask);
+}
+
+void simd_DiffMaskDouble
+(const double* const a, const double* const b, const int n,
+ unsigned long long* const mask)
+{
+	pthread_once(&m_simdOnce, simd_SelectKernels);
+	m_diffMaskDouble(a, b, n, mask);
+}
+
+void simd_ByteMask
+(const unsigned char* const p, const int n, 
+ const unsigned char* const lo, const unsigned char* const hi,
+ unsigned long long* const mask)
+{
+	pthread_once(&m_simdOnce, simd_SelectKernels);
+	m_byteMask(p, n, lo, hi, mask);
+}
@@ -0,0 +1,105 @@
+//
+//  simd.h
+//  MemGroups
+//
+//  Copyright (c) 2012 Cutout Pro. All rights reserved.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+	
+#ifndef MemGroups_simd_h
+#define MemGroups_simd_h
+	
+	//
+	//	VECTORIZED KERNELS
+	//
+	//	These are the inner loops that benefit from SIMD instructions.
+	//	The best version for the processor is selected the first time
+	//	a kernel is called. When the compiler or processor does not
+	//	support the instructions, a plain C version is used instead.
+	//
+	
+	//
+	// Returns the number of values at the beginning of a sorted array
+	// that are less than 'bound'.
+	// This is used by the bitstream operators to find how many
+	// boundaries in one bitstream come before the next boundary in
+	// the other, so they can be copied or skipped as a whole.
+	//
+	int simd_CountLess
+	(const int* const p, const int n, const int bound);
+	
+	enum {
+		SIMD_WORDS_AND = 1,
+		SIMD_WORDS_OR = 2,
+		SIMD_WORDS_ANDNOT = 3
+	};
+	
+	//
+	// Combines two arrays of 64 bit words into 'out'.
+	// ANDNOT keeps the bits in 'a' that are not in 'b'.
+	// 'out' may be the same array as 'a' or 'b'.
+	//
+	void simd_Words
+	(unsigned long long* const out, const unsigned long long* const a,
+	 const unsigned long long* const b, const int n, const int op);
+	
+	//
+	// Returns the number of bits set in an array of 64 bit words.
+	//
+	int simd_PopCount
+	(const unsigned long long* const p, const int n);
+	
+	//
+	// Sets bit i in 'mask' when lo <= p[i] <= hi, for 'n' values.
+	// The bits after the last value in the last word are cleared.
+	// This is used to build bitstreams from columns of values.
+	//
+	void simd_RangeMaskInt
+	(const int* const p, const int n, const int lo, const int hi,
+	 unsigned long long* const mask);
+	
+	//
+	// Like 'simd_RangeMaskInt', but for doubles.
+	// NaN is never inside the range.
+	//
+	void simd_RangeMaskDouble
+	(const double* const p, const int n, const double lo, const double hi,
+	 unsigned long long* const mask);
+	
+	//
+	// Sets bit i in 'mask' when a[i] != b[i], for 'n' values.
+	// The bits after the last value in the last word are cleared.
+	// This is used to find which values changed between two columns.
+	//
+	void simd_DiffMaskInt
+	(const int* const a, const int* const b, const int n,
+	 unsigned long long* const mask);
+	
+	//
+	// Like 'simd_DiffMaskInt', but for doubles.
+	// NaN differs from everything, like with the != operator.
+	//
+	void simd_DiffMaskDouble
+	(const double* const a, const double* const b, const int n,
+	 unsigned long long* const mask);
+	
+	//
+	// Sets bit i in 'mask' when (lo[p[i] & 15] & hi[p[i] >> 4]) != 0,
+	// for 'n' bytes. The tables of 16 entries describe a set of bytes
+	// by their low and high half, which is looked up with a shuffle
+	// instruction for 16 or 32 bytes at a time.
+	// The bits after the last byte in the last word are cleared.
+	//
+	void simd_ByteMask
+	(const unsigned char* const p, const int n, 
+	 const unsigned char* const lo, const unsigned char* const hi,
+	 unsigned long long* const mask);
+	
+#endif
+	
+#ifdef __cplusplus
+}
+#endif